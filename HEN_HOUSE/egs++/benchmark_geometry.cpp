@@ -0,0 +1,342 @@
+/*
+###############################################################################
+#
+#  EGSnrc egs++ geometry benchmarking utility
+#  Copyright (C) 2015 National Research Council Canada
+#
+#  This file is part of EGSnrc.
+#
+#  EGSnrc is free software: you can redistribute it and/or modify it under
+#  the terms of the GNU Affero General Public License as published by the
+#  Free Software Foundation, either version 3 of the License, or (at your
+#  option) any later version.
+#
+#  EGSnrc is distributed in the hope that it will be useful, but WITHOUT ANY
+#  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+#  FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public License for
+#  more details.
+#
+#  You should have received a copy of the GNU Affero General Public License
+#  along with EGSnrc. If not, see <http://www.gnu.org/licenses/>.
+#
+###############################################################################
+*/
+
+
+/*! \file benchmark_geometry.cpp
+ *  \brief Main program for benchmarking geometries
+ *
+ *  This program runs EGS_GeometryTester::benchmark() for a series of
+ *  geometries using the same benchmark definition, so that all
+ *  geometries are benchmarked with identical ray distributions. Usage:
+ *  \verbatim
+ *  gbench benchmark_input [geometry_file1 geometry_file2 ...]
+ *  \endverbatim
+ *  Each geometry file must contain a complete geometry definition
+ *  (e.g. the files in egs++/geometry/examples). The benchmark input
+ *  must contain a geometry tester definition with a \c benchmark
+ *  test (see EGS_GeometryTester::benchmark()). It can also contain
+ *  synthetic large geometries that are generated on the fly:
+ *  \verbatim
+ *  :start geometry tester:
+ *      :start benchmark:
+ *          :start bounding shape:
+ *              type = box
+ *              box size = 12
+ *          :stop bounding shape:
+ *          ntest = 100000
+ *          nrepeat = 5
+ *          output file = gbench.csv
+ *          label = my_version
+ *      :stop benchmark:
+ *  :stop geometry tester:
+ *
+ *  :start synthetic geometries:
+ *      xyz divisions = 512        # 512^3 XYZ geometry
+ *      mesh divisions = 55        # 6*55^3 (~10^6) tetrahedral mesh
+ *      autoenvelope seeds = 1000  # 1000 seeds in an XYZ base geometry
+ *      nd dimensions = 8          # ND geometry of 8 sets of planes
+ *  :stop synthetic geometries:
+ *  \endverbatim
+ *  All synthetic geometries fill (or are centred in) a 10 cm cube centred
+ *  at the origin. Synthetic geometries not mentioned in the input are
+ *  not run. The mesh geometry is written to the files \c gbench_mesh.node
+ *  and \c gbench_mesh.ele in the current directory, which are removed
+ *  after the mesh is loaded.
+ *
+ *  The results are appended to the output file, one line per geometry
+ *  and method, so that runs with different versions can be compared.
+ */
+
+#include "egs_base_geometry.h"
+#include "egs_geometry_tester.h"
+#include "egs_input.h"
+#include "egs_functions.h"
+#include "egs_math.h"
+
+#include <cstdio>
+#include <cstdarg>
+#include <string>
+using namespace std;
+
+static void addLine(string &s, const char *format, ...) {
+    char buf[1024];
+    va_list ap;
+    va_start(ap, format);
+    vsnprintf(buf,1024,format,ap);
+    va_end(ap);
+    s += buf;
+    s += '\n';
+}
+
+// An XYZ geometry with n^3 voxels. Every 7'th voxel is air so that
+// there are medium changes along the rays.
+static string syntheticXYZ(int n) {
+    string s;
+    addLine(s,":start geometry definition:");
+    addLine(s,"  :start geometry:");
+    addLine(s,"    library = egs_ndgeometry");
+    addLine(s,"    type = EGS_XYZGeometry");
+    addLine(s,"    name = xyz_%d",n);
+    EGS_Float d = 10./n;
+    addLine(s,"    x-slabs = -5 %.10g %d",d,n);
+    addLine(s,"    y-slabs = -5 %.10g %d",d,n);
+    addLine(s,"    z-slabs = -5 %.10g %d",d,n);
+    addLine(s,"    :start media input:");
+    addLine(s,"      media = water air");
+    addLine(s,"      set medium = 0 %d 1 7",n*n*n-1);
+    addLine(s,"    :stop media input:");
+    addLine(s,"  :stop geometry:");
+    addLine(s,"  simulation geometry = xyz_%d",n);
+    addLine(s,":stop geometry definition:");
+    return s;
+}
+
+// An ND geometry with ndim dimensions, each being a set of 6 planes with
+// a different normal.
+static string syntheticND(int ndim) {
+    string s;
+    addLine(s,":start geometry definition:");
+    string dims;
+    for (int j=0; j<ndim; j++) {
+        EGS_Float phi = M_PI*j/ndim, theta = 0.3 + 0.7*j/ndim;
+        addLine(s,"  :start geometry:");
+        addLine(s,"    library = egs_planes");
+        addLine(s,"    type = EGS_Planes");
+        addLine(s,"    name = nd_planes_%d",j);
+        addLine(s,"    normal = %.8f %.8f %.8f",sin(theta)*cos(phi),
+                sin(theta)*sin(phi),cos(theta));
+        addLine(s,"    positions = -5 -3 -1 1 3 5");
+        addLine(s,"  :stop geometry:");
+        char buf[32];
+        sprintf(buf," nd_planes_%d",j);
+        dims += buf;
+    }
+    addLine(s,"  :start geometry:");
+    addLine(s,"    library = egs_ndgeometry");
+    addLine(s,"    name = nd_%d",ndim);
+    addLine(s,"    dimensions =%s",dims.c_str());
+    addLine(s,"    :start media input:");
+    addLine(s,"      media = water air");
+    addLine(s,"      set medium = 0 %d 1 3",(int)(pow(5.,ndim)+0.5)-1);
+    addLine(s,"    :stop media input:");
+    addLine(s,"  :stop geometry:");
+    addLine(s,"  simulation geometry = nd_%d",ndim);
+    addLine(s,":stop geometry definition:");
+    return s;
+}
+
+// nseed spherical seeds on a regular lattice inside a 20^3 XYZ geometry.
+static string syntheticAEnvelope(int nseed) {
+    int nside = 1;
+    while (nside*nside*nside < nseed) {
+        nside++;
+    }
+    EGS_Float pitch = 9./nside;
+    string s;
+    addLine(s,":start geometry definition:");
+    addLine(s,"  :start geometry:");
+    addLine(s,"    library = egs_ndgeometry");
+    addLine(s,"    type = EGS_XYZGeometry");
+    addLine(s,"    name = aenv_base");
+    addLine(s,"    x-slabs = -5 0.5 20");
+    addLine(s,"    y-slabs = -5 0.5 20");
+    addLine(s,"    z-slabs = -5 0.5 20");
+    addLine(s,"    :start media input:");
+    addLine(s,"      media = water");
+    addLine(s,"    :stop media input:");
+    addLine(s,"  :stop geometry:");
+    addLine(s,"  :start geometry:");
+    addLine(s,"    library = egs_spheres");
+    addLine(s,"    name = aenv_seed");
+    addLine(s,"    midpoint = 0 0 0");
+    addLine(s,"    radii = 0.04 0.05");
+    addLine(s,"    :start media input:");
+    addLine(s,"      media = air titanium");
+    addLine(s,"      set medium = 1 1");
+    addLine(s,"    :stop media input:");
+    addLine(s,"  :stop geometry:");
+    addLine(s,"  :start geometry:");
+    addLine(s,"    library = egs_autoenvelope");
+    addLine(s,"    name = aenv_%d",nseed);
+    addLine(s,"    base geometry = aenv_base");
+    addLine(s,"    :start inscribed geometry:");
+    addLine(s,"      inscribed geometry name = aenv_seed");
+    addLine(s,"      :start transformations:");
+    for (int j=0; j<nseed; j++) {
+        int ix = j%nside, iy = (j/nside)%nside, iz = j/(nside*nside);
+        addLine(s,"        :start transformation:");
+        addLine(s,"          translation = %g %g %g",-4.5+(ix+0.5)*pitch,
+                -4.5+(iy+0.5)*pitch,-4.5+(iz+0.5)*pitch);
+        addLine(s,"        :stop transformation:");
+    }
+    addLine(s,"      :stop transformations:");
+    addLine(s,"      :start region discovery:");
+    addLine(s,"        density of random points (cm^-3) = 1e7");
+    addLine(s,"        :start shape:");
+    addLine(s,"          type = box");
+    addLine(s,"          box size = 0.1");
+    addLine(s,"        :stop shape:");
+    addLine(s,"      :stop region discovery:");
+    addLine(s,"    :stop inscribed geometry:");
+    addLine(s,"  :stop geometry:");
+    addLine(s,"  simulation geometry = aenv_%d",nseed);
+    addLine(s,":stop geometry definition:");
+    return s;
+}
+
+// A tetrahedral mesh of n^3 cubes, each split into 6 tetrahedra
+// along its main diagonal. The mesh is written in TetGen format.
+static string syntheticMesh(int n, const char *fname) {
+    string node_file = string(fname) + ".node", ele_file = string(fname) + ".ele";
+    FILE *fp = fopen(node_file.c_str(),"w");
+    if (!fp) {
+        egsWarning("syntheticMesh: failed to open %s for writing\n",
+                   node_file.c_str());
+        return string();
+    }
+    int nn = n+1;
+    EGS_Float d = 10./n;
+    fprintf(fp,"%d 3 0 0\n",nn*nn*nn);
+    for (int k=0; k<nn; k++) for (int j=0; j<nn; j++) for (int i=0; i<nn; i++) {
+                fprintf(fp,"%d %.10g %.10g %.10g\n",1+i+j*nn+k*nn*nn,
+                        -5+i*d,-5+j*d,-5+k*d);
+            }
+    fclose(fp);
+    fp = fopen(ele_file.c_str(),"w");
+    if (!fp) {
+        egsWarning("syntheticMesh: failed to open %s for writing\n",
+                   ele_file.c_str());
+        return string();
+    }
+    // the 6 paths from corner 0 to corner 7 of a cube, corners are
+    // numbered as ix + 2*iy + 4*iz
+    static const int paths[6][2] = {{1,3},{1,5},{2,3},{2,6},{4,5},{4,6}};
+    fprintf(fp,"%d 4 1\n",6*n*n*n);
+    int tag = 1;
+    for (int k=0; k<n; k++) for (int j=0; j<n; j++) for (int i=0; i<n; i++) {
+                int corner[8];
+                for (int c=0; c<8; c++) {
+                    corner[c] = 1 + (i+(c&1)) + (j+((c>>1)&1))*nn +
+                                (k+((c>>2)&1))*nn*nn;
+                }
+                int med = 1 + (i+j+k)%2;
+                for (int t=0; t<6; t++) {
+                    fprintf(fp,"%d %d %d %d %d %d\n",tag++,corner[0],
+                            corner[paths[t][0]],corner[paths[t][1]],corner[7],med);
+                }
+            }
+    fclose(fp);
+    string s;
+    addLine(s,":start geometry definition:");
+    addLine(s,"  :start geometry:");
+    addLine(s,"    library = egs_mesh");
+    addLine(s,"    name = mesh_%d",6*n*n*n);
+    addLine(s,"    file = %s",ele_file.c_str());
+    addLine(s,"  :stop geometry:");
+    addLine(s,"  simulation geometry = mesh_%d",6*n*n*n);
+    addLine(s,":stop geometry definition:");
+    return s;
+}
+
+static void runBenchmark(EGS_GeometryTester *tester, EGS_Input *input,
+                         const string &name) {
+    EGS_BaseGeometry *g = EGS_BaseGeometry::createGeometry(input);
+    if (!g) {
+        egsWarning("\nFailed to create geometry %s => skipping\n\n",
+                   name.c_str());
+    }
+    else {
+        tester->benchmark(g,name.c_str());
+    }
+    EGS_BaseGeometry::clearGeometries();
+}
+
+int main(int argc, char **argv) {
+
+    if (argc < 2) {
+        egsFatal("Usage: %s benchmark_input [geometry_file1 ...]\n",argv[0]);
+    }
+
+    EGS_Input input;
+    if (input.setContentFromFile(argv[1])) {
+        egsFatal("Failed to read the benchmark input %s\n",argv[1]);
+    }
+    EGS_GeometryTester *tester = EGS_GeometryTester::getGeometryTester(&input);
+    if (!tester) {
+        egsFatal("\nNo geometry tester? Check your input file\n\n");
+    }
+
+    for (int j=2; j<argc; j++) {
+        EGS_Input ginput;
+        if (ginput.setContentFromFile(argv[j])) {
+            egsWarning("Failed to read %s => skipping\n",argv[j]);
+            continue;
+        }
+        string name(argv[j]);
+        string::size_type pos = name.find_last_of("/\\");
+        if (pos != string::npos) {
+            name = name.substr(pos+1);
+        }
+        runBenchmark(tester,&ginput,name);
+    }
+
+    EGS_Input *isynth = input.takeInputItem("synthetic geometries");
+    if (isynth) {
+        int n;
+        if (!isynth->getInput("xyz divisions",n) && n > 0) {
+            string s = syntheticXYZ(n);
+            EGS_Input ginput;
+            ginput.setContentFromString(s);
+            runBenchmark(tester,&ginput,"synthetic_xyz");
+        }
+        if (!isynth->getInput("mesh divisions",n) && n > 0) {
+            string s = syntheticMesh(n,"gbench_mesh");
+            if (s.size()) {
+                EGS_Input ginput;
+                ginput.setContentFromString(s);
+                runBenchmark(tester,&ginput,"synthetic_mesh");
+                remove("gbench_mesh.node");
+                remove("gbench_mesh.ele");
+            }
+        }
+        if (!isynth->getInput("autoenvelope seeds",n) && n > 0) {
+            string s = syntheticAEnvelope(n);
+            EGS_Input ginput;
+            ginput.setContentFromString(s);
+            runBenchmark(tester,&ginput,"synthetic_autoenvelope");
+        }
+        if (!isynth->getInput("nd dimensions",n) && n > 0) {
+            string s = syntheticND(n);
+            EGS_Input ginput;
+            ginput.setContentFromString(s);
+            runBenchmark(tester,&ginput,"synthetic_nd");
+        }
+        delete isynth;
+    }
+
+    delete tester;
+
+    return 0;
+
+}
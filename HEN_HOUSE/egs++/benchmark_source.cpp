@@ -0,0 +1,285 @@
+/*
+###############################################################################
+#
+#  EGSnrc egs++ source benchmarking utility
+#  Copyright (C) 2015 National Research Council Canada
+#
+#  This file is part of EGSnrc.
+#
+#  EGSnrc is free software: you can redistribute it and/or modify it under
+#  the terms of the GNU Affero General Public License as published by the
+#  Free Software Foundation, either version 3 of the License, or (at your
+#  option) any later version.
+#
+#  EGSnrc is distributed in the hope that it will be useful, but WITHOUT ANY
+#  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+#  FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public License for
+#  more details.
+#
+#  You should have received a copy of the GNU Affero General Public License
+#  along with EGSnrc. If not, see <http://www.gnu.org/licenses/>.
+#
+###############################################################################
+*/
+
+
+/*! \file benchmark_source.cpp
+ *  \brief Main program for benchmarking particle sources
+ *
+ *  This program measures the sampling rate of all sources defined in
+ *  its input, using single particle sampling
+ *  (EGS_BaseSource::getNextParticle()) and batched sampling
+ *  (EGS_BaseSource::getNextParticles()). Usage:
+ *  \verbatim
+ *  sbench benchmark_input
+ *  \endverbatim
+ *  The input must contain a source definition (all sources defined in it
+ *  are benchmarked, in the order in which they were created), an optional
+ *  geometry definition for sources that need a geometry, and an optional
+ *  benchmark definition:
+ *  \verbatim
+ *  :start source benchmark:
+ *      nsample = 1000000     # particles per source and repetition
+ *      nrepeat = 5           # number of repetitions
+ *      batch size = 256      # particles per getNextParticles() call
+ *      output file = sbench.csv
+ *      label = my_version
+ *      dynamic control points = 500
+ *  :stop source benchmark:
+ *  \endverbatim
+ *  If \c dynamic \c control \c points is given, a synthetic dynamic source
+ *  (EGS_DynamicSource) is added, which moves a point source along an arc
+ *  with the given number of control points, alternating static (step and
+ *  shoot) and rotating segments. The input then does not need to define
+ *  any source.
+ *  For simple sources (EGS_BaseSimpleSource), the program also checks
+ *  that the batched sampling produces the same particles as the single
+ *  particle sampling. The results are appended to the output file, one
+ *  line per source and method, so that runs with different versions can
+ *  be compared.
+ */
+
+#include "egs_base_source.h"
+#include "egs_base_geometry.h"
+#include "egs_input.h"
+#include "egs_functions.h"
+#include "egs_rndm.h"
+#include "egs_math.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdarg>
+#include <string>
+using namespace std;
+
+typedef std::chrono::steady_clock Clock;
+
+static double elapsedNs(const Clock::time_point &t0,
+                        const Clock::time_point &t1) {
+    return std::chrono::duration<double,std::nano>(t1-t0).count();
+}
+
+static void addLine(string &s, const char *format, ...) {
+    char buf[1024];
+    va_list ap;
+    va_start(ap, format);
+    vsnprintf(buf,1024,format,ap);
+    va_end(ap);
+    s += buf;
+    s += '\n';
+}
+
+/* A dynamic source moving an isotropic point source 100 cm from the
+   isocentre along an arc with ncp control points. Every other segment has
+   constant angles (step and shoot), the others rotate the gantry and the
+   collimator. */
+static string syntheticDynamic(int ncp) {
+    string s;
+    addLine(s,":start source definition:");
+    addLine(s,"  :start source:");
+    addLine(s,"    library = egs_point_source");
+    addLine(s,"    name = sbench_point");
+    addLine(s,"    position = 0 0 0");
+    addLine(s,"    charge = 0");
+    addLine(s,"    :start spectrum:");
+    addLine(s,"      type = monoenergetic");
+    addLine(s,"      energy = 1");
+    addLine(s,"    :stop spectrum:");
+    addLine(s,"  :stop source:");
+    addLine(s,"  :start source:");
+    addLine(s,"    library = egs_dynamic_source");
+    addLine(s,"    name = dynamic_%d",ncp);
+    addLine(s,"    source name = sbench_point");
+    addLine(s,"    :start motion:");
+    for (int j=0; j<ncp; j++) {
+        EGS_Float a = 360.*(j/2)/ncp;
+        addLine(s,"      control point = 0 0 0 100 %g 0 %g %d",a,a/4,j);
+    }
+    addLine(s,"    :stop motion:");
+    addLine(s,"  :stop source:");
+    addLine(s,"  simulation source = dynamic_%d",ncp);
+    addLine(s,":stop source definition:");
+    return s;
+}
+
+/* A checksum of the sampled particles used to compare the batched and
+   single particle sampling. */
+static double checksum(int q, int latch, EGS_Float E, EGS_Float wt,
+                       const EGS_Vector &x, const EGS_Vector &u) {
+    return q + latch + E + wt + x.x + 2*x.y + 3*x.z + u.x + 2*u.y + 3*u.z;
+}
+
+int main(int argc, char **argv) {
+
+    if (argc < 2) {
+        egsFatal("Usage: %s benchmark_input\n",argv[0]);
+    }
+    EGS_Input input;
+    if (input.setContentFromFile(argv[1])) {
+        egsFatal("Failed to read the benchmark input %s\n",argv[1]);
+    }
+
+    int nsample = 1000000, nrepeat = 5, nbatch = 256, ndynamic = 0;
+    string ofile, label;
+    EGS_Input *ibench = input.takeInputItem("source benchmark");
+    if (ibench) {
+        int tmp;
+        if (!ibench->getInput("nsample",tmp) && tmp > 0) {
+            nsample = tmp;
+        }
+        if (!ibench->getInput("nrepeat",tmp) && tmp > 0) {
+            nrepeat = tmp;
+        }
+        if (!ibench->getInput("batch size",tmp) && tmp > 0) {
+            nbatch = tmp;
+        }
+        if (!ibench->getInput("dynamic control points",tmp) && tmp > 1) {
+            ndynamic = tmp;
+        }
+        ibench->getInput("output file",ofile);
+        ibench->getInput("label",label);
+        delete ibench;
+    }
+
+    EGS_Input *igeom = input.getInputItem("geometry definition");
+    if (igeom) {
+        if (!EGS_BaseGeometry::createGeometry(&input)) {
+            egsWarning("Failed to create the geometry, sources that need "
+                       "a geometry will not be created\n");
+        }
+    }
+    bool have_source = input.getInputItem("source definition") &&
+                       EGS_BaseSource::createSource(&input);
+    if (ndynamic > 0) {
+        string s = syntheticDynamic(ndynamic);
+        EGS_Input dinput;
+        dinput.setContentFromString(s);
+        if (EGS_BaseSource::createSource(&dinput)) {
+            have_source = true;
+        }
+    }
+    if (!have_source) {
+        egsFatal("\nNo source? Check your input file\n\n");
+    }
+    int nsource = EGS_BaseSource::nSources();
+
+    FILE *fp_bench = 0;
+    if (ofile.size() > 0) {
+        fp_bench = fopen(ofile.c_str(),"a");
+        if (!fp_bench) egsWarning("Failed to open file %s for writing\n",
+                                      ofile.c_str());
+        else if (fseek(fp_bench,0,SEEK_END) == 0 && ftell(fp_bench) == 0) {
+            fprintf(fp_bench,"label,source,type,method,nsample,nrepeat,"
+                    "batch_size,ns_per_particle,ns_sd,particles_per_s\n");
+        }
+    }
+
+    int *q = new int [nbatch], *latch = new int [nbatch];
+    EGS_Float *E = new EGS_Float [nbatch], *wt = new EGS_Float [nbatch];
+    EGS_Vector *x = new EGS_Vector [nbatch], *u = new EGS_Vector [nbatch];
+    double *ns = new double [2*nrepeat];
+    const char *methods[2] = {"single", "batched"};
+
+    egsInformation("\nSource benchmark: %d particles, %d repetitions, "
+                   "batch size %d\n\n",nsample,nrepeat,nbatch);
+    egsInformation("%-20s %-24s %-8s %10s %8s %14s\n","source","type",
+                   "method","ns/part.","sd","particles/s");
+    for (int is=0; is<nsource; is++) {
+        EGS_BaseSource *s = EGS_BaseSource::getSource(is);
+        if (!s) {
+            continue;
+        }
+        bool check = dynamic_cast<EGS_BaseSimpleSource *>(s) != 0;
+        bool same = true;
+        for (int r=0; r<nrepeat; r++) {
+            // Both methods use the same random number sequence
+            EGS_RandomGenerator *rndm = EGS_RandomGenerator::defaultRNG(r);
+            double sum1 = 0;
+            Clock::time_point t0 = Clock::now();
+            for (int j=0; j<nsample; j++) {
+                s->getNextParticle(rndm,q[0],latch[0],E[0],wt[0],x[0],u[0]);
+                sum1 += checksum(q[0],latch[0],E[0],wt[0],x[0],u[0]);
+            }
+            Clock::time_point t1 = Clock::now();
+            ns[r] = elapsedNs(t0,t1)/nsample;
+            delete rndm;
+
+            rndm = EGS_RandomGenerator::defaultRNG(r);
+            double sum2 = 0;
+            t0 = Clock::now();
+            for (int j=0; j<nsample; j+=nbatch) {
+                int n = nsample - j < nbatch ? nsample - j : nbatch;
+                s->getNextParticles(rndm,n,q,latch,E,wt,x,u);
+                for (int i=0; i<n; i++) {
+                    sum2 += checksum(q[i],latch[i],E[i],wt[i],x[i],u[i]);
+                }
+            }
+            t1 = Clock::now();
+            ns[nrepeat+r] = elapsedNs(t0,t1)/nsample;
+            delete rndm;
+            if (check && fabs(sum1-sum2) > 1e-10*fabs(sum1)) {
+                same = false;
+            }
+        }
+        for (int m=0; m<2; m++) {
+            double sum = 0, sum2 = 0;
+            for (int r=0; r<nrepeat; r++) {
+                double t = ns[m*nrepeat+r];
+                sum += t;
+                sum2 += t*t;
+            }
+            double mean = sum/nrepeat, sd = 0;
+            if (nrepeat > 1) {
+                sd = (sum2 - sum*mean)/(nrepeat-1);
+                sd = sd > 0 ? sqrt(sd) : 0;
+            }
+            double rate = mean > 0 ? 1e9/mean : 0;
+            egsInformation("%-20s %-24s %-8s %10.2f %8.2f %14.4g\n",
+                           s->getObjectName().c_str(),s->getObjectType().c_str(),
+                           methods[m],mean,sd,rate);
+            if (fp_bench) {
+                fprintf(fp_bench,"%s,%s,%s,%s,%d,%d,%d,%.4f,%.4f,%.6g\n",
+                        label.c_str(),s->getObjectName().c_str(),
+                        s->getObjectType().c_str(),methods[m],nsample,nrepeat,
+                        m ? nbatch : 1,mean,sd,rate);
+            }
+        }
+        if (!same) {
+            egsWarning("  *** batched sampling of source %s produced "
+                       "different particles\n",s->getObjectName().c_str());
+        }
+    }
+    if (fp_bench) {
+        fclose(fp_bench);
+    }
+
+    delete [] ns;
+    delete [] u;
+    delete [] x;
+    delete [] wt;
+    delete [] E;
+    delete [] latch;
+    delete [] q;
+
+    return 0;
+}
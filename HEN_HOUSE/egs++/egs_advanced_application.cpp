@@ -59,6 +59,16 @@
 #include <cstdarg>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
+#include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef WIN32
+    #include <io.h>
+#else
+    #include <dirent.h>
+#endif
 
 using namespace std;
 
@@ -116,6 +126,121 @@ extern __extc__ void egsGetElectronData(void (*func)(EGS_I32 *,EGS_Float *,
 extern __extc__ void egsGetPhotonData(void (*func)(EGS_I32 *,EGS_Float *,
                                       EGS_Float *,EGS_Float *,EGS_Float *),const EGS_I32 *,const EGS_I32 *);
 
+#define egsHatchState F77_OBJ_(egs_hatch_state,EGS_HATCH_STATE)
+extern __extc__ void egsHatchState(const EGS_I32 *, const char *, EGS_I32 *,
+                                   EGS_I32);
+
+/* 64-bit FNV-1a hash used for the cross section cache key */
+static void __xs_hash(unsigned long long &h, const void *data, size_t n) {
+    const unsigned char *c = (const unsigned char *)data;
+    for (size_t i=0; i<n; i++) {
+        h = (h^c[i])*1099511628211ULL;
+    }
+}
+
+static void __xs_hash(unsigned long long &h, const string &s) {
+    __xs_hash(h,s.c_str(),s.size()+1);
+}
+
+/* Hashes the name, size and modification time of the file fname.
+   Returns false if fname does not exist. */
+static bool __xs_hash_file(unsigned long long &h, const string &fname) {
+    struct stat buf;
+    if (stat(fname.c_str(),&buf)) {
+        return false;
+    }
+    __xs_hash(h,fname);
+    long long size = buf.st_size, mtime = buf.st_mtime;
+    __xs_hash(h,&size,sizeof(size));
+    __xs_hash(h,&mtime,sizeof(mtime));
+    return true;
+}
+
+/* Hashes all files in the directory dir (see __xs_hash_file()) */
+static void __xs_hash_dir(unsigned long long &h, const string &dir) {
+    vector<string> names;
+#ifdef WIN32
+    struct _finddata_t fdata;
+    intptr_t handle = _findfirst(egsJoinPath(dir,"*").c_str(),&fdata);
+    if (handle != -1) {
+        do {
+            if (!(fdata.attrib & _A_SUBDIR)) {
+                names.push_back(fdata.name);
+            }
+        }
+        while (_findnext(handle,&fdata) == 0);
+        _findclose(handle);
+    }
+#else
+    DIR *d = opendir(dir.c_str());
+    if (d) {
+        struct dirent *entry;
+        while ((entry = readdir(d)) != 0) {
+            if (entry->d_name[0] != '.') {
+                names.push_back(entry->d_name);
+            }
+        }
+        closedir(d);
+    }
+#endif
+    sort(names.begin(),names.end());
+    for (size_t j=0; j<names.size(); j++) {
+        __xs_hash_file(h,egsJoinPath(dir,names[j]));
+    }
+}
+
+static string __trim_fortran_string(const char *s, int n) {
+    string result(s,n);
+    size_t pos = result.find_last_not_of(' ');
+    return pos == string::npos ? string() : result.substr(0,pos+1);
+}
+
+/* Returns the name of the cross section cache file in the directory dir for
+   the current media and transport options, or an empty string if the pegs4
+   file pegs does not exist. The name contains a hash of everything HATCH
+   depends on: the cross section options, the media, and the names, sizes
+   and modification times of the pegs4 file and of the data files in the
+   HEN_HOUSE. */
+static string __xs_cache_file(const string &dir, const string &pegs,
+                              const string &hen_house, EGS_BaseGeometry *g,
+                              int nmed, const int *ind) {
+    unsigned long long h = 14695981039346656037ULL;
+    __xs_hash(h,string("EGSnrc cross section cache"));
+    int sizes[2] = { (int)sizeof(EGS_Float), MXMED };
+    __xs_hash(h,sizes,sizeof(sizes));
+    if (!__xs_hash_file(h,pegs)) {
+        return string();
+    }
+    __xs_hash(h,the_bounds,sizeof(*the_bounds));
+    __xs_hash(h,the_etcontrol,sizeof(*the_etcontrol));
+    __xs_hash(h,the_xoptions,sizeof(*the_xoptions));
+    __xs_hash(h,the_media,sizeof(*the_media));
+    __xs_hash(h,the_rayleigh,sizeof(*the_rayleigh));
+    for (int j=0; j<nmed; j++) {
+        __xs_hash(h,string(g->getMediumName(j)));
+        __xs_hash(h,&ind[j],sizeof(ind[j]));
+    }
+    string data_dir = egsJoinPath(hen_house,"data");
+    __xs_hash_dir(h,data_dir);
+    __xs_hash_dir(h,egsJoinPath(data_dir,"molecular_form_factors"));
+    if (the_xoptions->iraylr > 1) {
+        for (int j=0; j<MXMED; j++) {
+            string ff = __trim_fortran_string(the_rayleigh->ff_file[j],128);
+            if (ff.size() > 0) {
+                __xs_hash_file(h,ff);
+            }
+        }
+    }
+    string base = egsStripPath(pegs);
+    size_t pos = base.rfind('.');
+    if (pos != string::npos) {
+        base = base.substr(0,pos);
+    }
+    char key[32];
+    sprintf(key,".%016llx.xscache",h);
+    return egsJoinPath(dir,base+key);
+}
+
 static EGS_Float *__help1, *__help2, *__help3, *__help4;
 static EGS_I32 *__ihelp;
 static void __help_get_data(EGS_I32 *nbin,EGS_Float *emin, EGS_Float *emax,
@@ -493,6 +618,14 @@ int EGS_AdvancedApplication::helpInit(EGS_Input *transportp, bool do_hatch) {
     EGS_TransportProperty pxsec_out("Photon cross-sections output",&the_egsio->xsec_out);
     pxsec_out.addOption("Off");
     pxsec_out.addOption("On");
+    // Cross section cache files (<pegs file>.<hash>.xscache in the
+    // application directory) are never removed: every change of the media,
+    // options or data files creates a new one, old ones must be deleted by
+    // the user.
+    EGS_I32 xs_cache = 0;
+    EGS_TransportProperty xscache("Cross section cache",&xs_cache);
+    xscache.addOption("Off");
+    xscache.addOption("On");
     EGS_TransportProperty cxsec("Compton cross sections",16,the_media->compxsec);
     EGS_TransportProperty bc("Bound Compton scattering",&the_xoptions->ibcmp);
     bc.addOption("Off");
@@ -573,6 +706,7 @@ int EGS_AdvancedApplication::helpInit(EGS_Input *transportp, bool do_hatch) {
         skind.getInput(transportp);
         pxsec.getInput(transportp);
         pxsec_out.getInput(transportp);
+        xscache.getInput(transportp);
         cxsec.getInput(transportp);
         photonucxsec.getInput(transportp);
         photonuc.getInput(transportp);
@@ -640,7 +774,51 @@ int EGS_AdvancedApplication::helpInit(EGS_Input *transportp, bool do_hatch) {
 
     if (do_hatch) {
 
-        egsHatch();
+        // The cross section cache is not used in pegsless runs, where the
+        // media are defined in the input file, and when the photon cross
+        // sections are to be written out by HATCH.
+        string xs_file;
+        if (xs_cache && !is_pegsless && !the_egsio->xsec_out) {
+            const string &pfile = abs_pegs_file.size() ? abs_pegs_file :
+                                  pegs_file;
+            xs_file = __xs_cache_file(app_dir,pfile,hen_house,geometry,nmed,
+                                      ind);
+        }
+        EGS_I32 xs_err = 1;
+        if (xs_file.size() > 0) {
+            EGS_I32 iop = 2;
+            egsHatchState(&iop,xs_file.c_str(),&xs_err,xs_file.size());
+            if (xs_err == 2) {
+                egsFatal("initCrossSections(): failed to read the cross "
+                         "section cache %s\n  Delete this file and rerun\n",
+                         xs_file.c_str());
+            }
+            if (!xs_err) {
+                egsInformation("\nRead cross section data from %s\n",
+                               xs_file.c_str());
+            }
+        }
+        if (xs_err) {
+            egsHatch();
+            if (xs_file.size() > 0) {
+                // Write to a temporary file and rename it so that parallel
+                // jobs never read a partially written cache.
+                char buf[32];
+                sprintf(buf,".tmp%d",i_parallel);
+                string tmp_file = xs_file + buf;
+                EGS_I32 iop = 1;
+                egsHatchState(&iop,tmp_file.c_str(),&xs_err,tmp_file.size());
+                if (xs_err || rename(tmp_file.c_str(),xs_file.c_str())) {
+                    egsWarning("initCrossSections(): failed to write the "
+                               "cross section cache %s\n",xs_file.c_str());
+                    remove(tmp_file.c_str());
+                }
+                else {
+                    egsInformation("\nWrote cross section data to %s\n",
+                                   xs_file.c_str());
+                }
+            }
+        }
         F77_OBJ_(set_elastic_parameter,SET_ELASTIC_PARAMETER)();
 
         the_bounds->ecut_new = the_bounds->ecut;
@@ -771,6 +949,9 @@ int EGS_AdvancedApplication::helpInit(EGS_Input *transportp, bool do_hatch) {
     bca.info(nc);
     skind.info(nc);
     tran.info(nc);
+    if (do_hatch) {
+        xscache.info(nc);
+    }
     if (efield.size()==3) {
         efield.info(nc);
         the_emf->ExIN=efield_v[0];
@@ -942,6 +1123,7 @@ int EGS_AdvancedApplication::finishSimulation() {
         a_objects_list[j]->reportResults();
     }
     outputResults();
+    reportInstrumentation();
     finishRun();
     return 0;
 }
@@ -1102,6 +1284,10 @@ void EGS_AdvancedApplication::getElectronSteps(double &ch_steps,
     egsGetSteps(&ch_steps,&all_steps);
 }
 
+int EGS_AdvancedApplication::getStackSize() const {
+    return MXSTACK;
+}
+
 void EGS_AdvancedApplication::startNewParticle() {
     if (geometry->hasRhoScaling()) {
         int ireg = the_stack->ir[the_stack->np-1] - 2;
@@ -1222,12 +1408,34 @@ EGS_Float EGS_AdvancedApplication::getRM() {
 
 // Turns ON/OFF EGSnrc internal radiative splitting (UBS)
 void EGS_AdvancedApplication::setRadiativeSplitting(const EGS_Float &nsplit) {
+    checkSplitting(nsplit);
     the_egsvr->nbr_split = nsplit;
 }
 
+// The largest single push onto the stack with splitting is a positron
+// annihilation (ANNIH, ANNIH_AT_REST), which replaces the positron by
+// 2*nsplit photons. Reject splitting numbers for which this and the
+// particle being split cannot fit on the stack. This does not guarantee
+// that a run never overflows the stack, deeper showers still can.
+void EGS_AdvancedApplication::checkSplitting(EGS_Float nsplit) const {
+    int n = (int)nsplit;
+    if (2*n + 1 > MXSTACK) {
+        egsFatal("\n\n******************************************\n"
+                 "ERROR: with a splitting number of %d a positron\n"
+                 "annihilation puts 2*%d = %d photons on the stack, which\n"
+                 "together with the particle being split do not fit on\n"
+                 "the particle stack of size MXSTACK=%d.\n"
+                 "Increase MXSTACK in the array_sizes.h file of %s\n"
+                 "to at least %d and recompile the application.\n"
+                 "******************************************\n",
+                 n,n,2*n,MXSTACK,app_name.c_str(),2*n+1);
+    }
+}
+
 // Turns ON/OFF EGSnrc internal Russian Roulette + UBS
 void EGS_AdvancedApplication::setRussianRoulette(const EGS_Float &iSwitchRR) {
     if (iSwitchRR > 1.0) {
+        checkSplitting(iSwitchRR);
         the_egsvr->i_play_RR = 1;
         the_egsvr->prob_RR = 1.0/iSwitchRR;
         the_egsvr->nbr_split = iSwitchRR;
@@ -1260,16 +1468,17 @@ void EGS_AdvancedApplication::splitTopParticleIsotropically(const EGS_Float &fsp
             ++nsplit;
         }
     }
+    if (np + nsplit >= MXSTACK) {
+        egsFatal("\n\n******************************************\n"
+                 "ERROR: In EGS_AdvancedApplication::splitTopParticleIsotropically() :\n"
+                 "max. stack depth MXSTACK=%d < np=%d\n"
+                 "Stack overflow due to splitting!\n"
+                 "Increase MXSTACK in the array_sizes.h file of %s\n"
+                 "******************************************\n"
+                 ,MXSTACK,np+nsplit,app_name.c_str());
+    }
     for (int i=0; i < nsplit; i++) {
         np++;
-        if (np >= MXSTACK) {
-            egsFatal("\n\n******************************************\n"
-                     "ERROR: In EGS_AdvancedApplication::splitTopParticleIsotropically() :\n"
-                     "max. stack depth MXSTACK=%d < np=%d\n"
-                     "Stack overflow due to splitting!\n"
-                     "******************************************\n"
-                     ,MXSTACK,np);
-        }
         the_stack->x[np] = x;
         the_stack->y[np] = y;
         the_stack->z[np] = z;
@@ -1356,6 +1565,9 @@ extern __extc__ void egsHowfar() {
         the_epcont->idisc = 1;
         return;
     }
+    // geometries may need the charge of the particle (e.g. the macro-cell
+    // skipping of XYZ geometries), top_p is otherwise only set in egsAusgab
+    app->top_p.q = the_stack->iq[np];
     int newmed;
     int inew = app->howfar(ireg,
                            EGS_Vector(the_stack->x[np],the_stack->y[np],the_stack->z[np]),
@@ -1424,6 +1636,9 @@ extern __extc__ void egsAusgab(EGS_I32 *iarg) {
     app->top_p.ir = the_stack->ir[np]-2;
     app->top_p.latch = the_stack->latch[np];
     app->Np = the_stack->np-1;
+    if (app->Np > app->Np_max) {
+        app->Np_max = app->Np;
+    }
     *iarg = app->userScoring(*iarg);
 }
 
@@ -163,6 +163,10 @@ public:
      */
     void getElectronSteps(double &ch_steps, double &all_steps) const;
 
+    /*! \brief Returns the stack size \c MXSTACK the application was compiled
+      with */
+    int getStackSize() const;
+
     /*! Save the state of the RNG */
     virtual void saveRNGState();
 
@@ -243,6 +247,11 @@ public:
 
 protected:
 
+    /*! \brief Stops the run with a fatal error if the 2*\a nsplit photons
+      of the annihilation of a split positron and the particle being split
+      do not fit on the particle stack */
+    void checkSplitting(EGS_Float nsplit) const;
+
     int              nmed;      //!< number of media
     EGS_Interpolator *i_ededx;  //!< electron stopping power interpolator
     EGS_Interpolator *i_pdedx;  //!< positron stopping power interpolator
@@ -290,6 +299,19 @@ protected:
       about the media found in the geometry along with their cutoff energies
       and the values of all transport parameter and cross section
       options are printed using egsInformation.
+
+      With <code>Cross section cache = On</code> in the transport parameter
+      input, the cross section data obtained from \c HATCH is written to a
+      file in the application directory (see getAppDir()) and read back
+      instead of calling \c HATCH in later runs. The file name contains
+      a hash of the media, the pegs4 file, the transport parameter and
+      cross section options and the names, sizes and modification times
+      of the data files in <code>$HEN_HOUSE/data</code>, so that a change
+      in any of these leads to a new cache file. Cache files are never
+      pruned: files <code><pegs file>.<hash>.xscache</code> that are no
+      longer needed accumulate in the application directory and must be
+      deleted by hand. The cache is not used in pegsless runs and with
+      <code>Photon cross-sections output = On</code>.
     */
     int initCrossSections();
 
@@ -44,8 +44,7 @@ void EGS_AliasTable::clear() {
     if (n > 0) {
         delete [] fi;
         delete [] xi;
-        delete [] wi;
-        delete [] bin;
+        delete [] cells;
         n = 0;
     }
 }
@@ -58,13 +57,11 @@ void EGS_AliasTable::allocate(int N, int Type) {
     if (type == 0) {
         np = n;
         fi = new EGS_Float [n];
-        wi = new EGS_Float [n];
-        bin = new int [n];
+        cells = new Cell [n];
     }
     else {
         np = n-1;
-        wi = new EGS_Float [n-1];
-        bin = new int [n-1];
+        cells = new Cell [n-1];
         if (type == 1) {
             fi = new EGS_Float [n-1];
         }
@@ -82,8 +79,7 @@ void EGS_AliasTable::copy(const EGS_AliasTable &t) {
         for (int j=0; j<np; j++) {
             xi[j] = t.xi[j];
             fi[j] = t.fi[j];
-            wi[j] = t.wi[j];
-            bin[j] = t.bin[j];
+            cells[j] = t.cells[j];
         }
         if (type) {
             xi[np] = t.xi[np];
@@ -130,8 +126,8 @@ void EGS_AliasTable::make() {
             fcum[i] = 0.5*(fi[i]+fi[i+1])*(xi[i+1]-xi[i]);
         }
         sum += fcum[i];
-        wi[i] = 1;
-        bin[i] = 0;
+        cells[i].w = 1;
+        cells[i].alias = 0;
         not_done[i] = true;
         if (type == 0) {
             sum1 += fcum[i]*xi[i];
@@ -184,11 +180,31 @@ void EGS_AliasTable::make() {
         EGS_Float aux = sum - fcum[low_bin];
         fcum[high_bin] -= aux;
         not_done[jl] = false;
-        wi[low_bin] = fcum[low_bin]/sum;
-        bin[low_bin] = high_bin;
+        cells[low_bin].w = fcum[low_bin]/sum;
+        cells[low_bin].alias = high_bin;
     }
     delete [] fcum;
     delete [] not_done;
+    setCells();
+}
+
+void EGS_AliasTable::setCells() {
+    for (int i=0; i<np; i++) {
+        Cell &c = cells[i];
+        c.x = xi[i];
+        c.dx = type ? xi[i+1] - xi[i] : 0;
+        c.a = 0;
+        c.shape = 0;
+        if (type == 2 || type == 3) {
+            if (fi[i] > 0) {
+                c.a = fi[i+1]/fi[i]-1;
+                c.shape = fabs(c.a) < 0.2 ? 1 : 2;
+            }
+            else {
+                c.shape = 3;
+            }
+        }
+    }
 }
 
 #define AT_NCHECK 3
@@ -255,48 +271,48 @@ int EGS_AliasTable::initialize(EGS_Float xmin, EGS_Float xmax, EGS_Float accu,
 }
 
 int EGS_AliasTable::sampleBin(EGS_RandomGenerator *rndm) const {
-    EGS_Float r1 = rndm->getUniform();
-    EGS_Float aj = r1*np;
-    int j = (int) aj;
-    aj -= j;
-    if (aj > wi[j]) {
-        j = bin[j];
-    }
-    return j;
+    return selectBin(rndm->getUniform());
 }
 
 EGS_Float EGS_AliasTable::sample(EGS_RandomGenerator *rndm) const {
-    EGS_Float r1 = rndm->getUniform();
-    EGS_Float aj = r1*np;
-    int j = (int) aj;
-    aj -= j;
-    if (aj > wi[j]) {
-        j = bin[j];
-    }
+    int j = selectBin(rndm->getUniform());
     if (!type) {
         return xi[j];
     }
-    EGS_Float x = xi[j];
-    EGS_Float dx = xi[j+1] - x;
-    EGS_Float r2 = rndm->getUniform();
-    if (type == 1) {
-        return x + dx*r2;
-    }
-    EGS_Float res;
-    if (fi[j] > 0) {
-        EGS_Float a = fi[j+1]/fi[j]-1;
-        if (fabs(a) < 0.2) {
-            EGS_Float rnno1 = 0.5*(1-r2)*a;
-            res = x + r2*dx*(1+rnno1*(1-r2*a));
+    return pointInBin(j,rndm->getUniform());
+}
+
+void EGS_AliasTable::sample(int N, const EGS_Float *u, EGS_Float *x) const {
+    if (!type) {
+        for (int i=0; i<N; i++) {
+            x[i] = cells[selectBin(u[i])].x;
         }
-        else {
-            res = x - dx/a*(1-sqrt(1+r2*a*(2+a)));
+        return;
+    }
+    if (type == 1) {
+        for (int i=0; i<N; i++) {
+            const Cell &c = cells[selectBin(u[2*i])];
+            x[i] = c.x + c.dx*u[2*i+1];
         }
+        return;
     }
-    else {
-        res = x + dx*sqrt(r2);
+    for (int i=0; i<N; i++) {
+        x[i] = pointInBin(selectBin(u[2*i]),u[2*i+1]);
+    }
+}
+
+void EGS_AliasTable::sample(EGS_RandomGenerator *rndm, int N,
+                            EGS_Float *x) const {
+    const int nbuf = 256;
+    EGS_Float u[2*nbuf];
+    int nu = uniformsPerSample();
+    for (int i=0; i<N; i+=nbuf) {
+        int m = N - i < nbuf ? N - i : nbuf;
+        for (int k=0; k<m*nu; k++) {
+            u[k] = rndm->getUniform();
+        }
+        sample(m,u,x+i);
     }
-    return res;
 }
 
 
@@ -308,8 +324,7 @@ EGS_SimpleAliasTable::EGS_SimpleAliasTable(int N, const EGS_Float *f) : n(0) {
 
     // initialize data members
     n = N;
-    wi = new EGS_Float [n];
-    bins = new int [n];
+    cells = new Cell [n];
 
     // local variables
     int i;
@@ -318,7 +333,7 @@ EGS_SimpleAliasTable::EGS_SimpleAliasTable(int N, const EGS_Float *f) : n(0) {
 
     // initialize distribution and bin aliases, and compute histogram sum
     for (i=0; i<n; i++) {
-        bins[i] = i;
+        cells[i].alias = i;
         p[i] = f[i];
         sum += p[i];
     }
@@ -337,8 +352,8 @@ EGS_SimpleAliasTable::EGS_SimpleAliasTable(int N, const EGS_Float *f) : n(0) {
     vector<int> big_list;               // bins above average
     vector<int> small_list;             // bins below average
     for (i=0; i<n; i++) {
-        wi[i] = p[i]*n;
-        if (wi[i] <= 1.0) {
+        cells[i].w = p[i]*n;
+        if (cells[i].w <= 1.0) {
             small_list.push_back(i);
         }
         else {
@@ -355,12 +370,12 @@ EGS_SimpleAliasTable::EGS_SimpleAliasTable(int N, const EGS_Float *f) : n(0) {
         int small = small_list.back();
 
         // alias: fill small bin
-        bins[small] = big;              // alias small to big
-        wi[big] -= (1.0 - wi[small]);   // remove aliased portion from big bin
+        cells[small].alias = big;       // alias small to big
+        cells[big].w -= (1.0 - cells[small].w); // remove aliased portion from big bin
         small_list.pop_back();          // small bin is now filled
 
         // check if big bin is now small
-        if (wi[big] < 1.0 + epsilon) {
+        if (cells[big].w < 1.0 + epsilon) {
             big_list.pop_back();
             small_list.push_back(big);
         }
@@ -376,7 +391,6 @@ EGS_SimpleAliasTable::EGS_SimpleAliasTable(int N, const EGS_Float *f) : n(0) {
 
 EGS_SimpleAliasTable::~EGS_SimpleAliasTable() {
     if (n > 0) {
-        delete [] wi;
-        delete [] bins;
+        delete [] cells;
     }
 }
@@ -134,6 +134,28 @@ public:
     /*! \brief Get a random point from this table using the RNG \a rndm. */
     EGS_Float sample(EGS_RandomGenerator *rndm) const;
 
+    /*! \brief Get \a N random points from this table using the RNG \a rndm.
+
+      The points are the same as the ones obtained with \a N successive
+      calls to sample().
+    */
+    void sample(EGS_RandomGenerator *rndm, int N, EGS_Float *x) const;
+
+    /*! \brief Get \a N random points from this table using the uniform
+      random numbers \a u.
+
+      Each point uses uniformsPerSample() consecutive numbers from \a u,
+      in the order in which sample() would draw them, so that \a u must
+      hold <code>N*uniformsPerSample()</code> numbers.
+    */
+    void sample(int N, const EGS_Float *u, EGS_Float *x) const;
+
+    /*! \brief Number of uniform random numbers needed per sampled point
+      (1 for a table of type 0, 2 otherwise). */
+    int uniformsPerSample() const {
+        return type ? 2 : 1;
+    };
+
     /*! \brief Get a random bin from this table.  */
     int sampleBin(EGS_RandomGenerator *rndm) const;
 
@@ -150,13 +172,28 @@ public:
 
 private:
 
+    /*! \brief The data needed to sample a point in one bin.
+
+      The alias decision and the sampling within the bin only use the
+      cells of the selected bin and of its alias, so that each lookup
+      touches a single cache line instead of the xi, fi, wi and bin arrays.
+    */
+    struct Cell {
+        EGS_Float w;     //!< probability of keeping the bin
+        EGS_Float x;     //!< lower bin edge (the point for type 0)
+        EGS_Float dx;    //!< bin width
+        EGS_Float a;     //!< fi[j+1]/fi[j]-1 for interpolated tables
+        int       alias; //!< alias bin
+        int       shape; /*!< 0 => uniform, 1 => nearly uniform linear,
+                              2 => linear, 3 => linear with fi[j]=0 */
+    };
+
     int       n;     //!< number of subintervals
     int       np;    //!< =n for type=0, =n-1 else.
     EGS_Float *fi;   //!< array of function values
     EGS_Float *xi;   //!< array of coordinates
-    EGS_Float *wi;   //!< array of bin branching probabilities
+    Cell      *cells;//!< per-bin sampling data
     EGS_Float average;
-    int       *bin;  //!< bins
     int       type;  /*!< 0 => sum of delta functions, 1 => histogram
                       2 => linear interpolation between bin edges */
 
@@ -164,6 +201,35 @@ private:
     void      clear();
     void      allocate(int N, int Type);
     void      make();
+    void      setCells();
+
+    /*! \brief The bin selected by the uniform random number \a r1 */
+    int selectBin(EGS_Float r1) const {
+        EGS_Float aj = r1*np;
+        int j = (int) aj;
+        aj -= j;
+        return aj > cells[j].w ? cells[j].alias : j;
+    };
+
+    /*! \brief The point in bin \a j selected by the uniform random
+      number \a r2 (not used for type 0) */
+    EGS_Float pointInBin(int j, EGS_Float r2) const {
+        const Cell &c = cells[j];
+        if (!type) {
+            return c.x;
+        }
+        if (c.shape == 0) {
+            return c.x + c.dx*r2;
+        }
+        if (c.shape == 1) {
+            EGS_Float rnno1 = 0.5*(1-r2)*c.a;
+            return c.x + r2*c.dx*(1+rnno1*(1-r2*c.a));
+        }
+        if (c.shape == 2) {
+            return c.x - c.dx/c.a*(1-sqrt(1+r2*c.a*(2+c.a)));
+        }
+        return c.x + c.dx*sqrt(r2);
+    };
 
 
 };
@@ -200,14 +266,43 @@ public:
     */
     int sample(EGS_RandomGenerator *rndm) const {
         int bin = (int)(rndm->getUniform()*n);
-        return rndm->getUniform() < wi[bin] ? bin : bins[bin];
+        const Cell &c = cells[bin];
+        return rndm->getUniform() < c.w ? bin : c.alias;
+    };
+
+    /*! \brief Sample a random bin using the single random number \a u
+
+    The integer part of \c u*n selects the bin and the fractional part
+    decides between the bin and its alias. Useful when \a u has already
+    been drawn, e.g. to replace a search through cumulative probabilities
+    without changing the number of random numbers used.
+    */
+    int sampleBin(EGS_Float u) const {
+        EGS_Float r = u*n;
+        int bin = (int)r;
+        if (bin >= n) {
+            bin = n-1;
+        }
+        const Cell &c = cells[bin];
+        return r - bin < c.w ? bin : c.alias;
+    };
+
+    /*! \brief The number of bins */
+    int size() const {
+        return n;
     };
 
 private:
 
+    /*! \brief The branching probability and the alias of a bin, stored
+      together so that sampling a bin touches a single cache line. */
+    struct Cell {
+        EGS_Float w;      //!< probability of keeping the bin
+        int       alias;  //!< alias bin
+    };
+
     int       n;          //!< number of subintervals
-    EGS_Float *wi;        //!< array of bin branching probabilities
-    int       *bins;      //!< bins
+    Cell      *cells;     //!< per-bin branching probabilities and aliases
 
 };
 
@@ -50,6 +50,7 @@
 #include "egs_simple_container.h"
 #include "egs_ausgab_object.h"
 #include "egs_base_geometry.h"
+#include "egs_timer.h"
 
 #include <cstring>
 #include <cstdio>
@@ -116,6 +117,7 @@ int EGS_Application::userScoring(int iarg, int ir) {
         int early_return = 0;
         for (int j=0; j<a_objects[iarg].size(); ++j) {
             int res;
+            EGS_INSTRUMENT_AUSGAB(a_objects[iarg][j]);
             if (ir > -1) {
                 res = a_objects[iarg][j]->processEvent((AusgabCall)iarg, ir);
             }
@@ -137,6 +139,7 @@ int EGS_Application::userScoring(int iarg, int ir) {
         return 0;
     }
     else {
+        EGS_INSTRUMENT_CALL(Ausgab);
         return ausgab(iarg);
     }
 }
@@ -227,10 +230,14 @@ void EGS_Application::storeGeometryStep(int ireg, int inew,
 
 EGS_Application::EGS_Application(int argc, char **argv) : input(0), geometry(0),
     source(0), rndm(0), run(0), simple_run(false), uniform_run(false), current_case(0),
-    last_case(0), data_out(0), data_in(0), a_objects(0),
-    ghistory(new EGS_GeometryHistory) {
+    last_case(0), time_block(0), time_bin(0), time_block_n(0), time_block_i(0),
+    time_block_left(0), time_preset(false), data_out(0), data_in(0), a_objects(0),
+    ghistory(new EGS_GeometryHistory), instrumentation(0), Np_max(-1) {
 
     app_index = n_apps++;
+#ifdef EGS_INSTRUMENT
+    instrumentation = new EGS_Instrumentation;
+#endif
 
     if (!active_egs_application) {
         active_egs_application = this;
@@ -514,6 +521,9 @@ int EGS_Application::outputData() {
             return 6;
         }
     }
+    if (instrumentation && !instrumentation->storeState(*data_out)) {
+        return 7;
+    }
     return 0;
 }
 
@@ -550,6 +560,10 @@ int EGS_Application::readData() {
             return 6;
         }
     }
+    if (instrumentation) {
+        instrumentation->resetCounter();
+        instrumentation->addState(*data_in);
+    }
     return 0;
 }
 
@@ -562,7 +576,9 @@ void EGS_Application::resetCounter() {
     for (int j=0; j<a_objects_list.size(); ++j) {
         a_objects_list[j]->resetCounter();
     }
-
+    if (instrumentation) {
+        instrumentation->resetCounter();
+    }
 }
 
 int EGS_Application::addState(istream &data) {
@@ -585,6 +601,9 @@ int EGS_Application::addState(istream &data) {
         if (!a_objects_list[j]->addState(data)) {
             return 5;
         }
+    if (instrumentation) {
+        instrumentation->addState(data);
+    }
     return 0;
 }
 
@@ -618,6 +637,7 @@ int EGS_Application::combinePartialResults() {
         a_objects_list[j]->reportResults();
     }
     outputResults();
+    reportInstrumentation();
     return 0;
 }
 
@@ -753,24 +773,40 @@ int EGS_Application::initRNG() {
 int EGS_Application::initSimulation() {
     //if( !input ) { egsWarning("%s no input\n",__egs_app_msg2); return -1; }
     egsInformation("In EGS_Application::initSimulation()\n");
+    // CPU time spent in each initialization step, reported at the end so
+    // that the start-up cost of short (parallel) jobs can be assessed.
+    enum { tGeometry, tSource, tRNG, tRunControl, tBackEnd, tCrossSections,
+           tScoring, tAusgab, nInitStep
+         };
+    static const char *init_steps[nInitStep] = {
+        "geometry", "source", "RNG", "run control", "back-end",
+        "cross sections", "scoring", "ausgab objects"
+    };
+    EGS_Float t_init[nInitStep];
+    EGS_Timer timer;
+    timer.start();
     int err;
     bool ok = true;
     err = initGeometry();
+    t_init[tGeometry] = timer.time();
     if (err) {
         egsWarning("\n\n%s geometry initialization failed\n",__egs_app_msg2);
         ok = false;
     }
     err = initSource();
+    t_init[tSource] = timer.time();
     if (err) {
         egsWarning("\n\n%s source initialization failed\n",__egs_app_msg2);
         ok = false;
     }
     err = initRNG();
+    t_init[tRNG] = timer.time();
     if (err) {
         egsWarning("\n\n%s RNG initialization failed\n",__egs_app_msg2);
         ok = false;
     }
     err = initRunControl();
+    t_init[tRunControl] = timer.time();
     if (err) {
         egsWarning("\n\n%s run control initialization failed\n",__egs_app_msg2);
         ok = false;
@@ -779,25 +815,39 @@ int EGS_Application::initSimulation() {
         return 1;
     }
     err = initEGSnrcBackEnd();
+    t_init[tBackEnd] = timer.time();
     if (err) {
         egsWarning("\n\n%s back-end initialization failed\n",__egs_app_msg2);
         return 2;
     }
     describeUserCode();
     err = initCrossSections();
+    t_init[tCrossSections] = timer.time();
     if (err) {
         egsWarning("\n\n%s cross section initialization failed\n",__egs_app_msg2);
         return 3;
     }
     err = initScoring();
+    t_init[tScoring] = timer.time();
     if (err) {
         egsWarning("\n\n%s scoring initialization failed with status %d\n",
                    __egs_app_msg2,err);
         return 4;
     }
     initAusgabObjects();
+    t_init[tAusgab] = timer.time();
     //describeSimulation();
 
+    egsInformation("\nInitialization CPU time (s):");
+    EGS_Float t_last = 0;
+    for (int j=0; j<nInitStep; j++) {
+        egsInformation(" %s %.3f%c",init_steps[j],t_init[j]-t_last,
+                       j < nInitStep-1 ? ',' : '\n');
+        t_last = t_init[j];
+    }
+    egsInformation("%-40s%.3f (sec.)\n\n","Total initialization CPU time:",
+                   t_last);
+
     return 0;
 }
 
@@ -893,6 +943,8 @@ int EGS_Application::runSimulation() {
                 next_chunk = false;
                 break;
             }
+            time_block_left = ncase_per_batch;
+            time_block_n = time_block_i = 0;
             for (EGS_I64 icase=0; icase<ncase_per_batch; icase++) {
                 if (simulateSingleShower()) {
                     egsInformation("  simulateSingleShower() "
@@ -900,7 +952,9 @@ int EGS_Application::runSimulation() {
                     next_chunk = false;
                     break;
                 }
+                --time_block_left;
             }
+            time_block_left = 0;
             if (!next_chunk) {
                 break;
             }
@@ -916,6 +970,53 @@ int EGS_Application::runSimulation() {
     return 0;
 }
 
+EGS_Float EGS_Application::getNextTimeIndex() {
+    if (time_block_i < time_block_n) {
+        return time_block[time_block_i++];
+    }
+    int nmax = run ? run->timeBlockSize : 0;
+    if (nmax < 1 || time_block_left < 1) {
+        return -1;
+    }
+    if (!time_block) {
+        // the second half is used as scratch space by the bucket sort
+        time_block = new EGS_Float [2*nmax];
+        time_bin = new int [nmax+1];
+    }
+    // Only as many time indices as there are histories left in the batch,
+    // otherwise the unused ones at the end of the batch would be the largest
+    // of their block and the time distribution would be biased.
+    int n = time_block_left < nmax ? time_block_left : nmax;
+    EGS_Float *t = time_block + nmax;
+    for (int j=0; j<=n; j++) {
+        time_bin[j] = 0;
+    }
+    for (int j=0; j<n; j++) {
+        t[j] = rndm->getUniform();
+        int bin = (int)(t[j]*n);
+        if (bin >= n) {
+            bin = n-1;
+        }
+        ++time_bin[bin+1];
+    }
+    // Bucket sort into n bins of width 1/n. The order within a bin (on
+    // average one time index) does not matter, motion segments are much
+    // longer than that.
+    for (int j=0; j<n; j++) {
+        time_bin[j+1] += time_bin[j];
+    }
+    for (int j=0; j<n; j++) {
+        int bin = (int)(t[j]*n);
+        if (bin >= n) {
+            bin = n-1;
+        }
+        time_block[time_bin[bin]++] = t[j];
+    }
+    time_block_n = n;
+    time_block_i = 0;
+    return time_block[time_block_i++];
+}
+
 int EGS_Application::simulateSingleShower() {
     int ireg;
     int ntry = 0;
@@ -928,17 +1029,31 @@ int EGS_Application::simulateSingleShower() {
                        " attempts\n");
             return 1;
         }
-        setTimeIndex(-1);
-        current_case =
-            source->getNextParticle(rndm,p.q,p.latch,p.E,p.wt,p.x,p.u);
+        EGS_Float tpreset = getNextTimeIndex();
+        setTimeIndex(tpreset);
+        time_preset = tpreset >= 0;
+        {
+            EGS_INSTRUMENT_CALL(Source);
+            current_case =
+                source->getNextParticle(rndm,p.q,p.latch,p.E,p.wt,p.x,p.u);
+        }
+        // Sources without time information reset the time index
+        if (tpreset >= 0 && getTimeIndex() < 0) {
+            setTimeIndex(tpreset);
+        }
+        time_preset = time_preset && getTimeIndex() == tpreset;
 
         // For dynamic geometries, update positions according to the current
         // time index, which may have been set by getNextParticle
         geometry->getNextGeom(rndm);
 
-        ireg = geometry->isWhere(p.x);
+        {
+            EGS_INSTRUMENT_CALL(IsWhere);
+            ireg = geometry->isWhere(p.x);
+        }
         if (ireg < 0) {
             EGS_Float t = veryFar;
+            EGS_INSTRUMENT_CALL(Howfar);
             ireg = geometry->howfar(ireg,p.x,p.u,t);
             if (ireg >= 0) {
                 p.x += p.u*t;
@@ -951,7 +1066,10 @@ int EGS_Application::simulateSingleShower() {
     if (err) {
         return err;
     }
-    err = shower();
+    {
+        EGS_INSTRUMENT_CALL(Shower);
+        err = shower();
+    }
     if (err) {
         return err;
     }
@@ -971,6 +1089,10 @@ EGS_Application::~EGS_Application() {
     if (rndm) {
         delete rndm;
     }
+    if (time_block) {
+        delete [] time_block;
+        delete [] time_bin;
+    }
     if (run) {
         delete run;
     }
@@ -1001,6 +1123,9 @@ EGS_Application::~EGS_Application() {
     if (ghistory) {
         delete ghistory;
     }
+    if (instrumentation) {
+        delete instrumentation;
+    }
     if (active_egs_application == this) {
         active_egs_application = 0;
     }
@@ -1022,6 +1147,9 @@ void EGS_Application::addAusgabObject(EGS_AusgabObject *o) {
     }
     o->setApplication(this);
     a_objects_list.add(o);
+    if (instrumentation) {
+        instrumentation->addAusgabObject(o,o->getObjectName());
+    }
     //int ncall = 1 + (int)AugerEvent;
     int ncall = (int)UnknownCall;
     if (!a_objects) {
@@ -1060,6 +1188,7 @@ int EGS_Application::finishSimulation() {
     for (int j=0; j<a_objects_list.size(); ++j) {
         a_objects_list[j]->reportResults();
     }
+    reportInstrumentation();
 
     if (data_out) {
         delete data_out;
@@ -1084,6 +1213,12 @@ int EGS_Application::finishSimulation() {
     return err;
 }
 
+void EGS_Application::reportInstrumentation() {
+    if (instrumentation) {
+        instrumentation->report(run ? run->getCPUTime() : 0);
+    }
+}
+
 void EGS_Application::fillRandomArray(int n, EGS_Float *rarray) {
     rndm->fillArray(n,rarray);
 }
@@ -45,6 +45,7 @@
 #include "egs_base_source.h"
 #include "egs_simple_container.h"
 #include "egs_interpolator.h"
+#include "egs_instrumentation.h"
 
 #include <string>
 #include <iostream>
@@ -626,6 +627,7 @@ public:
     inline int howfar(int ireg, const EGS_Vector &x, const EGS_Vector &u,
                       EGS_Float &t, int *newmed) {
 
+        EGS_INSTRUMENT_CALL(Howfar);
         geometry->resetErrorFlag();
         EGS_Float twant = t;
         int inew = geometry->howfar(ireg,x,u,t,newmed);
@@ -643,6 +645,7 @@ public:
      This function implements the EGSnrc hownear geometry specification
     */
     inline EGS_Float hownear(int ireg,const EGS_Vector &x) {
+        EGS_INSTRUMENT_CALL(Hownear);
         return geometry->hownear(ireg,x);
     };
 
@@ -662,6 +665,7 @@ public:
         return geometry->isRealRegion(ireg);
     }
     int  isWhere(EGS_Vector &r) {
+        EGS_INSTRUMENT_CALL(IsWhere);
         return geometry->isWhere(r);
     }
 
@@ -715,6 +719,33 @@ public:
         source->setTimeIndex(temp_time);
     }
 
+    /*! \brief Returns the time index to preset for the next source particle,
+      or -1 if the time sorted mode is off.
+
+      If the run control input specifies a <code>time sorted block size</code>
+      \f$N > 0\f$, this function samples up to \f$N\f$ uniform time indices at
+      once, sorts them (into bins of width \f$1/N\f$) and returns them one by
+      one in increasing order, so that dynamic geometries mostly keep their
+      position between consecutive histories. A block is never larger than the number of histories left in
+      the current batch. As each history uses at least one time index, all
+      time indices of a block are used before the batch ends, so the time
+      indices stay independent and uniformly distributed. Outside of the
+      shower loop of runSimulation() this returns -1.
+     */
+    EGS_Float getNextTimeIndex();
+
+    /*! \brief Returns true if the current time index was preset by
+      getNextTimeIndex() and not replaced by the source.
+
+      A preset time index is a uniform random number just like one sampled
+      by a dynamic geometry or shape, so these can reject it and sample
+      a new one if it falls outside of their control points. A time index
+      provided by the source cannot be changed without changing the particle.
+     */
+    bool isTimeIndexPreset() const {
+        return time_preset;
+    }
+
     /*! \brief User scoring function for accumulation of results and VRT implementation
 
       This function first calls the processEvent() method of the ausgab objects
@@ -825,6 +856,16 @@ public:
         all_steps = 0;
     };
 
+    /*! \brief Returns the capacity of the particle stack.
+
+     The default implementation returns 0 (unknown). Applications using the
+     mortran back-end return the stack size they were compiled with
+     (\c MXSTACK in their \c array_sizes.h file).
+     */
+    virtual int getStackSize() const {
+        return 0;
+    };
+
     /*! \brief Add data from a parallel job.
 
       This function is called from within the loop over parallel jobs
@@ -1058,6 +1099,10 @@ protected:
 
     void reportGeometryError();
 
+    /*! \brief Prints the instrumentation breakdown, if instrumentation
+      was compiled in (see EGS_Instrumentation). */
+    void reportInstrumentation();
+
     EGS_Input           *input;         //!< the input to this simulation.
     EGS_BaseGeometry    *geometry;      //!< the geometry of this simulation
     EGS_BaseSource      *source;        //!< the particle source
@@ -1091,6 +1136,14 @@ protected:
     EGS_I64      current_case; //!< The current case as returned from the source
     EGS_I64      last_case;    //!< The last case simulated.
 
+    /*! \brief Sorted time indices of the current block (see getNextTimeIndex()) */
+    EGS_Float    *time_block;
+    int          *time_bin;       //!< Bucket boundaries used to sort a block
+    int          time_block_n;    //!< Number of time indices in the block
+    int          time_block_i;    //!< Index of the next time index to use
+    EGS_I64      time_block_left; //!< Histories left in the current batch
+    bool         time_preset;     //!< See isTimeIndexPreset()
+
     /*! \brief data output stream
 
      Points to the data stream opened for output in
@@ -1118,6 +1171,13 @@ protected:
 
     EGS_GeometryHistory *ghistory;
 
+    /*! \brief Call counters for the hot paths of the simulation.
+
+     Only created if egs++ and the application are compiled with
+     \c EGS_INSTRUMENT defined (see EGS_Instrumentation), otherwise null.
+    */
+    EGS_Instrumentation *instrumentation;
+
 private:
 
     static int n_apps; //!< Number of applications constructed so far.
@@ -1126,6 +1186,9 @@ public:
 
     EGS_Particle top_p;  //!< The top particle on the stack (i.e., the particle being transported)
     int          Np;     //!< The index of the top particle on the stack
+    /*! \brief The largest \c Np seen by ausgab() so far, so that the stack
+      size needed by a run can be reported (-1 before the first call) */
+    int          Np_max;
     //************************************************************
     // Utility functions for use with ausgab dose scoring objects
     //************************************************************
@@ -1215,8 +1278,22 @@ public:
     }
 };
 
+/*! \brief Stops with a fatal error if the application and the egs++ library
+  were compiled with different \c EGS_FLOAT_REGION_DATA settings
+
+  Called by APP_MAIN and APP_LIB, see EGS_RegionFloat.
+*/
+static inline void egsCheckRegionFloat() {
+    if (egsRegionFloatSize() != (int)sizeof(EGS_RegionFloat)) {
+        egsFatal("The egs++ library and this application were compiled "
+                 "with different\n  EGS_FLOAT_REGION_DATA settings => "
+                 "rebuild the application\n");
+    }
+}
+
 #define APP_MAIN(app_name) \
     int main(int argc, char **argv) { \
+        egsCheckRegionFloat(); \
         app_name app(argc,argv); \
         int err = app.initSimulation(); \
         if( err ) return err; \
@@ -1237,6 +1314,7 @@ public:
 #define APP_LIB(app_name) \
     extern "C" {\
         APP_EXPORT EGS_Application* createApplication(int argc, char **argv) {\
+            egsCheckRegionFloat();\
             return new app_name(argc,argv);\
         }\
     }
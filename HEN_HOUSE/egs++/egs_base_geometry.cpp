@@ -311,6 +311,10 @@ string EGS_GeometryPrivate::libkey = "library";
 string EGS_GeometryPrivate::create_key = "createGeometry";
 #endif
 
+int egsRegionFloatSize() {
+    return sizeof(EGS_RegionFloat);
+}
+
 int EGS_BaseGeometry::active_glist = 0;
 
 static char buf_unique[32];
@@ -820,7 +824,7 @@ void EGS_BaseGeometry::setRelativeRho(int start, int end, EGS_Float rho) {
     if (end >= start) {
         int j;
         if (!rhor) {
-            rhor = new EGS_Float [nreg];
+            rhor = new EGS_RegionFloat [nreg];
             for (j=0; j<nreg; j++) {
                 rhor[j] = 1;
             }
@@ -868,7 +872,7 @@ void EGS_BaseGeometry::setBScaling(int start, int end, EGS_Float bf) {
     if (end >= start) {
         int j;
         if (!bfactor) {
-            bfactor = new EGS_Float [nreg];
+            bfactor = new EGS_RegionFloat [nreg];
             for (j=0; j<nreg; j++) {
                 bfactor[j] = 1.0;
             }
@@ -68,6 +68,40 @@ struct EGS_GeometryIntersections;
     typedef unsigned char EGS_BPType;
 #endif
 
+/*! \brief The type of the per-region relative mass densities and B field
+  scaling factors of a geometry.
+
+  These arrays have one entry per region and dominate the memory use of
+  large voxel geometries with density scaling (\em e.g. 1 GB per array
+  for a 512^3 XYZ geometry in double precision). If the macro \c EGS_FLOAT_REGION_DATA
+  is defined when compiling the egs++ library \em and the application
+  (\em e.g. by adding <code>-DEGS_FLOAT_REGION_DATA</code> to the \c opt
+  variable of the egs++ configuration), they are stored in single
+  precision, which halves their size. Region boundaries and all geometry
+  arithmetic stay in EGS_Float.
+
+  The egs++ library, all geometry libraries and every application must be
+  compiled with the same setting: the arrays are accessed by inline
+  functions, so an application compiled without the macro would silently
+  read the float array of the library as double (and vice versa). After
+  changing the setting, the library and all applications must therefore
+  be rebuilt. Applications using APP_MAIN or APP_LIB stop with a fatal
+  error at startup when their setting differs from the one of the
+  library (see egsRegionFloatSize()).
+*/
+#ifdef EGS_FLOAT_REGION_DATA
+    typedef float EGS_RegionFloat;
+#else
+    typedef EGS_Float EGS_RegionFloat;
+#endif
+
+/*! \brief Returns sizeof(EGS_RegionFloat) as compiled into the egs++ library
+
+  Used to detect applications compiled with a different
+  \c EGS_FLOAT_REGION_DATA setting than the library, see EGS_RegionFloat.
+*/
+EGS_EXPORT int egsRegionFloatSize();
+
 class label {
 public:
     string      name;
@@ -276,6 +310,25 @@ public:
         return 0;
     }
 
+    /*! \brief Gets an axis-aligned box enclosing the geometry
+
+      Sets \a xmin and \a xmax to the lower and upper corners of a box that
+      contains every region of this geometry and returns true. Coordinates
+      in which the geometry extends to infinity are set to +/-veryFar.
+      The box must enclose the geometry but does not need to be tight.
+      The default implementation returns false, which means that the
+      extent of the geometry is unknown. Composite geometries use the box
+      to avoid querying constituents a particle can not reach
+      (see EGS_BoundingBoxTree).
+
+      Currently implemented in EGS_Box, EGS_cSpheres, EGS_cSphericalShell,
+      EGS_PlanesT, EGS_CylindersT, EGS_NDGeometry, EGS_XYZGeometry,
+      EGS_TransformedGeometry and the envelope and CD geometries.
+    */
+    virtual bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+        return false;
+    }
+
     /*! \brief Returns the number of local regions in this geometry.
 
       The fact that this method is not virtual implies that derived
@@ -801,7 +854,7 @@ protected:
     /*! \brief Array with relative mass densities.
 
      */
-    EGS_Float *rhor;
+    EGS_RegionFloat *rhor;
 
     /*! \brief Does this geometry has B field scaling factor?
 
@@ -811,7 +864,7 @@ protected:
     /*! \brief Array with B field scaling factors.
 
      */
-    EGS_Float *bfactor;
+    EGS_RegionFloat *bfactor;
 
     /*! \brief Reference density for B field scaling.
 
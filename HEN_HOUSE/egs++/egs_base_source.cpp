@@ -86,3 +86,11 @@ void EGS_BaseSource::addKnownSource(EGS_BaseSource *o) {
 void EGS_BaseSource::addKnownTypeId(const char *tid) {
     source_creator.addKnownTypeId(tid);
 }
+
+int EGS_BaseSource::nSources() {
+    return source_creator.nObjects();
+}
+
+EGS_BaseSource *EGS_BaseSource::getSource(int j) {
+    return dynamic_cast<EGS_BaseSource *>(source_creator.getObject(j));
+}
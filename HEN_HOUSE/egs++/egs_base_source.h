@@ -137,6 +137,34 @@ public:
                                     EGS_Float &E, EGS_Float &wt,       // energy and weight
                                     EGS_Vector &x, EGS_Vector &u) = 0; // position and direction
 
+    /*! \brief Sample the next \a n source particles.
+     *
+     *  Sets the first \a n elements of the arrays \a q, \a latch, \a E,
+     *  \a wt, \a x and \a u to the parameters of the next \a n particles
+     *  and returns the number of statistically independent particles
+     *  sampled so far after the last particle. If \a icase is not null,
+     *  the return value of getNextParticle() for each particle
+     *  is stored in \a icase.
+     *
+     *  The default implementation calls getNextParticle() \a n times.
+     *  Derived classes may re-implement this method to avoid the
+     *  per-particle overhead, but must produce exactly the same particles
+     *  (in the same order and using the same random numbers) as \a n
+     *  calls to getNextParticle().
+     */
+    virtual EGS_I64 getNextParticles(EGS_RandomGenerator *rndm, int n,
+                                     int *q, int *latch, EGS_Float *E, EGS_Float *wt,
+                                     EGS_Vector *x, EGS_Vector *u, EGS_I64 *icase = 0) {
+        EGS_I64 ncase = 0;
+        for (int j=0; j<n; ++j) {
+            ncase = getNextParticle(rndm,q[j],latch[j],E[j],wt[j],x[j],u[j]);
+            if (icase) {
+                icase[j] = ncase;
+            }
+        }
+        return ncase;
+    };
+
     /*! \brief Set the next simulation chunk to start at \a nstart and
       to consist of \a nrun particles.
 
@@ -301,6 +329,12 @@ public:
      */
     static EGS_BaseSource *getSource(const string &Name);
 
+    /*! \brief Returns the number of sources in the internal list */
+    static int nSources();
+
+    /*! \brief Returns the j'th source in the internal list */
+    static EGS_BaseSource *getSource(int j);
+
     /*! \brief Add a known source object to the source factory.
      *
      * This function adds the object \a o to the list of known sources
@@ -430,6 +464,22 @@ public:
         return e;
     };
 
+    /*! \brief Sample \a n particle energies into \a E.
+     *
+     * Gives the same energies (using the same random numbers) as \a n
+     * calls to sampleEnergy() and updates the counters in the same way.
+     * The energies are obtained from the protected virtual method
+     * sampleBatch().
+     */
+    void sampleEnergies(EGS_RandomGenerator *rndm, int n, EGS_Float *E) {
+        sampleBatch(rndm,n,E);
+        for (int j=0; j<n; ++j) {
+            count++;
+            sum_E += E[j];
+            sum_E2 += E[j]*E[j];
+        }
+    };
+
     /*! \brief Get the maximum energy of this spectrum.
      *
      * This pure virtual method must be reimplemented by derived classes
@@ -585,6 +635,18 @@ protected:
      */
     virtual EGS_Float sample(EGS_RandomGenerator *rndm) = 0;
 
+    /*! \brief Sample \a n energies from the spectrum energy distribution.
+     *
+     * The default implementation calls sample() \a n times. Derived
+     * classes may re-implement this method with a faster batched version,
+     * which must give the same energies as the default implementation.
+     */
+    virtual void sampleBatch(EGS_RandomGenerator *rndm, int n, EGS_Float *E) {
+        for (int j=0; j<n; ++j) {
+            E[j] = sample(rndm);
+        }
+    };
+
     /*! \brief Number of times the sampleEnergy() method was called.*/
     EGS_I64 count;
 
@@ -854,6 +916,37 @@ protected:
         latch = 0;
     };
 
+    /*! \brief Batch sampling for a simple source of type \a T.
+     *
+     * Implements getNextParticles() for \a src, which must be \a this,
+     * by calling T::getPositionDirection() and T::setLatch() directly,
+     * so that the compiler can inline them into the sampling loop. Derived
+     * classes with a simple getPositionDirection() re-implement
+     * getNextParticles() using this function. If \a src is actually of
+     * a type derived from \a T, the default implementation is used instead,
+     * as it may re-implement the above functions.
+     */
+    template <class T>
+    EGS_I64 sampleParticles(T *src, EGS_RandomGenerator *rndm, int n,
+                            int *Q, int *latch, EGS_Float *E, EGS_Float *wt,
+                            EGS_Vector *x, EGS_Vector *u, EGS_I64 *icase) {
+        if (typeid(*src) != typeid(T)) {
+            return EGS_BaseSource::getNextParticles(rndm,n,Q,latch,E,wt,x,u,
+                                                    icase);
+        }
+        for (int j=0; j<n; ++j) {
+            Q[j] = q;
+            E[j] = s->sampleEnergy(rndm);
+            src->T::getPositionDirection(rndm,x[j],u[j],wt[j]);
+            src->T::setLatch(latch[j]);
+            ++count;
+            if (icase) {
+                icase[j] = count;
+            }
+        }
+        return count;
+    };
+
     /*! \brief The charge of this simple source */
     int              q;
 
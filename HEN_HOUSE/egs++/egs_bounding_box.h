@@ -0,0 +1,523 @@
+/*
+###############################################################################
+#
+#  EGSnrc egs++ bounding box tree headers
+#  Copyright (C) 2015 National Research Council Canada
+#
+#  This file is part of EGSnrc.
+#
+#  EGSnrc is free software: you can redistribute it and/or modify it under
+#  the terms of the GNU Affero General Public License as published by the
+#  Free Software Foundation, either version 3 of the License, or (at your
+#  option) any later version.
+#
+#  EGSnrc is distributed in the hope that it will be useful, but WITHOUT ANY
+#  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+#  FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public License for
+#  more details.
+#
+#  You should have received a copy of the GNU Affero General Public License
+#  along with EGSnrc. If not, see <http://www.gnu.org/licenses/>.
+#
+###############################################################################
+*/
+
+
+/*! \file egs_bounding_box.h
+ *  \brief EGS_BoundingBoxTree class header file
+ */
+
+#ifndef EGS_BOUNDING_BOX_
+#define EGS_BOUNDING_BOX_
+
+#include "egs_base_geometry.h"
+#include "egs_transformations.h"
+#include "egs_functions.h"
+
+#include <vector>
+#include <algorithm>
+
+/*! \brief A bounding volume hierarchy over a set of geometries.
+
+  \ingroup egspp_main
+
+  Composite geometries such as envelopes, unions and stacks must, in
+  general, ask every one of their constituent geometries whether a particle
+  will enter it or is inside it. With many constituents this becomes the
+  dominant cost of a howfar() call. An EGS_BoundingBoxTree collects the
+  axis-aligned bounding boxes returned by
+  EGS_BaseGeometry::getBoundingBox() for a set of geometries and arranges
+  them in a binary tree (median split along the longest axis of the box
+  centres). The tree can then be queried for the geometries whose boxes
+  - are intersected by a ray segment (rayCandidates()),
+  - contain a point (pointCandidates()), or
+  - are closer to a point than a given distance (nearCandidates()).
+
+  Candidate lists are always returned sorted by geometry index, so that
+  composite geometries that depend on the order in which constituents are
+  checked produce the same result as without the tree.
+  Geometries for which no bounding box is available are returned as
+  candidates by every query. Boxes are padded by a multiple of the
+  boundary tolerance passed to build() so that particles sitting on a
+  boundary are never missed.
+*/
+class EGS_BoundingBoxTree {
+
+public:
+
+    EGS_BoundingBoxTree() : n(0), nbounded(0) {};
+
+    /*! \brief Builds the tree for the \a N geometries in \a geoms.
+
+      \a tol is the boundary tolerance of the composite geometry using the
+      tree. Any previously built tree is discarded.
+     */
+    void build(int N, EGS_BaseGeometry **geoms, EGS_Float tol) {
+        n = N;
+        nbounded = 0;
+        nodes.clear();
+        items.clear();
+        always.clear();
+        bmin.assign(n,EGS_Vector());
+        bmax.assign(n,EGS_Vector());
+        has_box.assign(n,0);
+        for (int j=0; j<n; j++) {
+            EGS_Vector a, b;
+            if (geoms[j] && geoms[j]->getBoundingBox(a,b)) {
+                pad(a.x,-tol);
+                pad(a.y,-tol);
+                pad(a.z,-tol);
+                pad(b.x,tol);
+                pad(b.y,tol);
+                pad(b.z,tol);
+                bmin[j] = a;
+                bmax[j] = b;
+                has_box[j] = 1;
+                items.push_back(j);
+                ++nbounded;
+            }
+            else {
+                always.push_back(j);
+            }
+        }
+        if (nbounded > 0) {
+            nodes.reserve(2*nbounded);
+            nodes.push_back(Node());
+            buildNode(0,0,nbounded);
+        }
+    };
+
+    //! Returns the number of geometries in the tree
+    int size() const {
+        return n;
+    };
+
+    //! Returns the number of geometries with a known bounding box
+    int nBounded() const {
+        return nbounded;
+    };
+
+    /*! \brief Gets the bounding box of geometry \a j as stored in the tree
+
+      Returns false if geometry \a j has no bounding box.
+     */
+    bool getBox(int j, EGS_Vector &xmin, EGS_Vector &xmax) const {
+        if (j < 0 || j >= n || !has_box[j]) {
+            return false;
+        }
+        xmin = bmin[j];
+        xmax = bmax[j];
+        return true;
+    };
+
+    /*! \brief Puts into \a list the geometries that the ray segment from
+      \a x along \a u with length \a t may intersect.
+
+      \a list must have room for size() entries. Returns the number of
+      candidates.
+     */
+    int rayCandidates(const EGS_Vector &x, const EGS_Vector &u, EGS_Float t,
+                      int *list) const {
+        int nc = addAlways(list);
+        if (!nbounded) {
+            return nc;
+        }
+        int stack[max_depth], ns = 0;
+        stack[ns++] = 0;
+        while (ns > 0) {
+            const Node &node = nodes[stack[--ns]];
+            if (!rayHitsBox(node.xmin,node.xmax,x,u,t)) {
+                continue;
+            }
+            if (node.count > 0) {
+                for (int i=node.first; i<node.first+node.count; i++) {
+                    int j = items[i];
+                    if (node.count == 1 || rayHitsBox(bmin[j],bmax[j],x,u,t)) {
+                        list[nc++] = j;
+                    }
+                }
+            }
+            else {
+                stack[ns++] = node.first;
+                stack[ns++] = node.first+1;
+            }
+        }
+        std::sort(list,list+nc);
+        return nc;
+    };
+
+    /*! \brief Puts into \a list the geometries whose bounding box contains
+      the point \a x and returns their number.
+     */
+    int pointCandidates(const EGS_Vector &x, int *list) const {
+        int nc = addAlways(list);
+        if (!nbounded) {
+            return nc;
+        }
+        int stack[max_depth], ns = 0;
+        stack[ns++] = 0;
+        while (ns > 0) {
+            const Node &node = nodes[stack[--ns]];
+            if (!boxContains(node.xmin,node.xmax,x)) {
+                continue;
+            }
+            if (node.count > 0) {
+                for (int i=node.first; i<node.first+node.count; i++) {
+                    int j = items[i];
+                    if (node.count == 1 || boxContains(bmin[j],bmax[j],x)) {
+                        list[nc++] = j;
+                    }
+                }
+            }
+            else {
+                stack[ns++] = node.first;
+                stack[ns++] = node.first+1;
+            }
+        }
+        std::sort(list,list+nc);
+        return nc;
+    };
+
+    /*! \brief Puts into \a list the geometries whose bounding box is closer
+      than \a tmax to the point \a x and returns their number.
+
+      Because the boxes enclose the geometries, the distance to a box is a
+      lower bound of the distance to the geometry. Geometries not in
+      the list are therefore at least \a tmax away from \a x.
+     */
+    int nearCandidates(const EGS_Vector &x, EGS_Float tmax, int *list) const {
+        int nc = addAlways(list);
+        if (!nbounded) {
+            return nc;
+        }
+        EGS_Float t2 = tmax*tmax;
+        int stack[max_depth], ns = 0;
+        stack[ns++] = 0;
+        while (ns > 0) {
+            const Node &node = nodes[stack[--ns]];
+            if (boxDistance2(node.xmin,node.xmax,x) >= t2) {
+                continue;
+            }
+            if (node.count > 0) {
+                for (int i=node.first; i<node.first+node.count; i++) {
+                    int j = items[i];
+                    if (node.count == 1 || boxDistance2(bmin[j],bmax[j],x) < t2) {
+                        list[nc++] = j;
+                    }
+                }
+            }
+            else {
+                stack[ns++] = node.first;
+                stack[ns++] = node.first+1;
+            }
+        }
+        std::sort(list,list+nc);
+        return nc;
+    };
+
+    /*! \brief Returns the geometry whose bounding box is nearest to \a x
+
+      Returns -1 if none of the geometries has a bounding box. Useful to
+      get a good initial estimate before calling nearCandidates().
+     */
+    int nearest(const EGS_Vector &x) const {
+        if (!nbounded) {
+            return -1;
+        }
+        int jbest = items[0];
+        EGS_Float d2best = boxDistance2(bmin[jbest],bmax[jbest],x);
+        int stack[max_depth], ns = 0;
+        stack[ns++] = 0;
+        while (ns > 0 && d2best > 0) {
+            const Node &node = nodes[stack[--ns]];
+            if (boxDistance2(node.xmin,node.xmax,x) >= d2best) {
+                continue;
+            }
+            if (node.count > 0) {
+                for (int i=node.first; i<node.first+node.count; i++) {
+                    int j = items[i];
+                    EGS_Float d2 = boxDistance2(bmin[j],bmax[j],x);
+                    if (d2 < d2best) {
+                        d2best = d2;
+                        jbest = j;
+                    }
+                }
+            }
+            else {
+                stack[ns++] = node.first;
+                stack[ns++] = node.first+1;
+            }
+        }
+        return jbest;
+    };
+
+    /*! \brief Returns a lower bound of the distance between \a x and
+      geometry \a j (0 if \a x is inside its box or the geometry has no box).
+     */
+    EGS_Float distance(int j, const EGS_Vector &x) const {
+        if (!has_box[j]) {
+            return 0;
+        }
+        return sqrt(boxDistance2(bmin[j],bmax[j],x));
+    };
+
+    /*! \brief Returns true if the ray segment from \a x along \a u with length
+      \a t may intersect geometry \a j.
+     */
+    bool mayHit(int j, const EGS_Vector &x, const EGS_Vector &u,
+                EGS_Float t) const {
+        return !has_box[j] || rayHitsBox(bmin[j],bmax[j],x,u,t);
+    };
+
+    /*! \brief Returns false if \a x is definitely outside geometry \a j */
+    bool mayContain(int j, const EGS_Vector &x) const {
+        return !has_box[j] || boxContains(bmin[j],bmax[j],x);
+    };
+
+    /*! \brief Transforms the box (\a xmin, \a xmax) with the affine
+      transformation \a T.
+
+      On return, \a xmin and \a xmax are the corners of the axis-aligned box
+      enclosing the transformed box. Infinite extents (\em i.e. coordinates
+      set to +/-veryFar) are only preserved along the axes they are rotated
+      into.
+     */
+    static void transformBox(const EGS_AffineTransform &T,
+                             EGS_Vector &xmin, EGS_Vector &xmax) {
+        EGS_Vector c = (xmin + xmax)*0.5, h = (xmax - xmin)*0.5;
+        EGS_Vector tc = T*c;
+        const EGS_RotationMatrix &R = T.getRotation();
+        EGS_Vector th(fabs(R.xx())*h.x + fabs(R.xy())*h.y + fabs(R.xz())*h.z,
+                      fabs(R.yx())*h.x + fabs(R.yy())*h.y + fabs(R.yz())*h.z,
+                      fabs(R.zx())*h.x + fabs(R.zy())*h.y + fabs(R.zz())*h.z);
+        xmin = tc - th;
+        xmax = tc + th;
+    };
+
+    /*! \brief Sets (\a xmin, \a xmax) to the intersection of itself with
+      the box (\a amin, \a amax).
+     */
+    static void intersectBox(const EGS_Vector &amin, const EGS_Vector &amax,
+                             EGS_Vector &xmin, EGS_Vector &xmax) {
+        if (amin.x > xmin.x) {
+            xmin.x = amin.x;
+        }
+        if (amin.y > xmin.y) {
+            xmin.y = amin.y;
+        }
+        if (amin.z > xmin.z) {
+            xmin.z = amin.z;
+        }
+        if (amax.x < xmax.x) {
+            xmax.x = amax.x;
+        }
+        if (amax.y < xmax.y) {
+            xmax.y = amax.y;
+        }
+        if (amax.z < xmax.z) {
+            xmax.z = amax.z;
+        }
+    };
+
+    /*! \brief Sets (\a xmin, \a xmax) to the smallest box enclosing itself and
+      the box (\a amin, \a amax).
+     */
+    static void mergeBox(const EGS_Vector &amin, const EGS_Vector &amax,
+                         EGS_Vector &xmin, EGS_Vector &xmax) {
+        if (amin.x < xmin.x) {
+            xmin.x = amin.x;
+        }
+        if (amin.y < xmin.y) {
+            xmin.y = amin.y;
+        }
+        if (amin.z < xmin.z) {
+            xmin.z = amin.z;
+        }
+        if (amax.x > xmax.x) {
+            xmax.x = amax.x;
+        }
+        if (amax.y > xmax.y) {
+            xmax.y = amax.y;
+        }
+        if (amax.z > xmax.z) {
+            xmax.z = amax.z;
+        }
+    };
+
+private:
+
+    /* A tree node. Leaves have count > 0 and hold items[first...first+count-1],
+       internal nodes have count = 0 and children first and first+1. */
+    struct Node {
+        EGS_Vector xmin, xmax;
+        int first, count;
+    };
+
+    enum { max_leaf = 4, max_depth = 128 };
+
+    int                     n;        // number of geometries
+    int                     nbounded; // number of geometries with a box
+    std::vector<Node>       nodes;
+    std::vector<int>        items;    // geometry indices, ordered by leaf
+    std::vector<int>        always;   // geometries without a box
+    std::vector<EGS_Vector> bmin, bmax;
+    std::vector<char>       has_box;
+
+    static void pad(EGS_Float &c, EGS_Float tol) {
+        c += tol*(4 + fabs(c));
+    };
+
+    int addAlways(int *list) const {
+        int nc = always.size();
+        for (int i=0; i<nc; i++) {
+            list[i] = always[i];
+        }
+        return nc;
+    };
+
+    /* Fills node inode with items[first...last-1]. Children are allocated
+       as consecutive pairs so that only the index of the first child is
+       needed. */
+    void buildNode(int inode, int first, int last) {
+        EGS_Vector a(bmin[items[first]]), b(bmax[items[first]]);
+        EGS_Vector ca(veryFar,veryFar,veryFar), cb(-veryFar,-veryFar,-veryFar);
+        for (int i=first; i<last; i++) {
+            int j = items[i];
+            mergeBox(bmin[j],bmax[j],a,b);
+            EGS_Vector c = centre(j);
+            mergeBox(c,c,ca,cb);
+        }
+        nodes[inode].xmin = a;
+        nodes[inode].xmax = b;
+        if (last - first <= max_leaf) {
+            nodes[inode].first = first;
+            nodes[inode].count = last - first;
+            return;
+        }
+        EGS_Vector d = cb - ca;
+        int axis = d.x >= d.y && d.x >= d.z ? 0 : (d.y >= d.z ? 1 : 2);
+        int mid = (first + last)/2;
+        std::nth_element(items.begin()+first,items.begin()+mid,
+                         items.begin()+last,CentreLess(this,axis));
+        int ichild = nodes.size();
+        nodes.push_back(Node());
+        nodes.push_back(Node());
+        nodes[inode].first = ichild;
+        nodes[inode].count = 0;
+        buildNode(ichild,first,mid);
+        buildNode(ichild+1,mid,last);
+    };
+
+    EGS_Vector centre(int j) const {
+        EGS_Vector c = (bmin[j] + bmax[j])*0.5;
+        return c;
+    };
+
+    struct CentreLess {
+        const EGS_BoundingBoxTree *tree;
+        int axis;
+        CentreLess(const EGS_BoundingBoxTree *t, int a) : tree(t), axis(a) {};
+        bool operator()(int i, int j) const {
+            EGS_Vector ci = tree->centre(i), cj = tree->centre(j);
+            if (axis == 0) {
+                return ci.x < cj.x;
+            }
+            if (axis == 1) {
+                return ci.y < cj.y;
+            }
+            return ci.z < cj.z;
+        };
+    };
+
+    static bool slab(EGS_Float a, EGS_Float b, EGS_Float x, EGS_Float u,
+                     EGS_Float &tmin, EGS_Float &tmax) {
+        if (u > 0) {
+            EGS_Float t1 = (a-x)/u, t2 = (b-x)/u;
+            if (t1 > tmin) {
+                tmin = t1;
+            }
+            if (t2 < tmax) {
+                tmax = t2;
+            }
+        }
+        else if (u < 0) {
+            EGS_Float t1 = (b-x)/u, t2 = (a-x)/u;
+            if (t1 > tmin) {
+                tmin = t1;
+            }
+            if (t2 < tmax) {
+                tmax = t2;
+            }
+        }
+        else if (x < a || x > b) {
+            return false;
+        }
+        return tmin <= tmax;
+    };
+
+    static bool rayHitsBox(const EGS_Vector &a, const EGS_Vector &b,
+                           const EGS_Vector &x, const EGS_Vector &u, EGS_Float t) {
+        EGS_Float tmin = 0, tmax = t;
+        return slab(a.x,b.x,x.x,u.x,tmin,tmax) &&
+               slab(a.y,b.y,x.y,u.y,tmin,tmax) &&
+               slab(a.z,b.z,x.z,u.z,tmin,tmax);
+    };
+
+    static bool boxContains(const EGS_Vector &a, const EGS_Vector &b,
+                            const EGS_Vector &x) {
+        return x.x >= a.x && x.x <= b.x && x.y >= a.y && x.y <= b.y &&
+               x.z >= a.z && x.z <= b.z;
+    };
+
+    static EGS_Float boxDistance2(const EGS_Vector &a, const EGS_Vector &b,
+                                  const EGS_Vector &x) {
+        EGS_Float d2 = 0, d;
+        if (x.x < a.x) {
+            d = a.x - x.x;
+            d2 += d*d;
+        }
+        else if (x.x > b.x) {
+            d = x.x - b.x;
+            d2 += d*d;
+        }
+        if (x.y < a.y) {
+            d = a.y - x.y;
+            d2 += d*d;
+        }
+        else if (x.y > b.y) {
+            d = x.y - b.y;
+            d2 += d*d;
+        }
+        if (x.z < a.z) {
+            d = a.z - x.z;
+            d2 += d*d;
+        }
+        else if (x.z > b.z) {
+            d = x.z - b.z;
+            d2 += d*d;
+        }
+        return d2;
+    };
+};
+
+#endif
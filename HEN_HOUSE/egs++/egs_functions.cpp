@@ -341,6 +341,27 @@ int egsGetPid() {
 #endif
 }
 
+#ifndef WIN32
+    #include <sys/resource.h>
+#endif
+
+long egsPeakMemory() {
+#ifdef WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF,&usage)) {
+        return 0;
+    }
+#ifdef __APPLE__
+    // ru_maxrss is in bytes on macOS
+    return usage.ru_maxrss/1024;
+#else
+    return usage.ru_maxrss;
+#endif
+#endif
+}
+
 string egsSimplifyCVSKey(const string &key) {
     if (key.size() < 2) {
         return key;
@@ -254,6 +254,13 @@ string EGS_EXPORT egsHostName();
  */
 int EGS_EXPORT egsGetPid();
 
+/*! \brief Get the peak resident memory of the process in kB.
+ *
+ * Returns 0 if the peak memory can not be determined on this system.
+ * \ingroup egspp_main
+ */
+long EGS_EXPORT egsPeakMemory();
+
 /*! \brief Get the endianess of the machine.
  *
  * Returns 0, of the machine is big-endian, 1 if it is little endian,
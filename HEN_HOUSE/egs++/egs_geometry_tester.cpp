@@ -45,6 +45,7 @@
 
 #include <cstdio>
 #include <string>
+#include <chrono>
 using namespace std;
 
 //static int __geometry_error = 0;
@@ -74,12 +75,14 @@ public:
         EGS_Object::deleteObject(hownear_time_shape);
         EGS_Object::deleteObject(howfar_shape);
         EGS_Object::deleteObject(howfar_time_shape);
+        EGS_Object::deleteObject(bench_shape);
     };
     void testInside(EGS_BaseGeometry *);
     void testInsideTime(EGS_BaseGeometry *);
     void testHownear(int ntry, EGS_BaseGeometry *);
     void testHownearTime(EGS_BaseGeometry *);
     void testHowfar(EGS_BaseGeometry *, bool time);
+    void benchmark(EGS_BaseGeometry *, const char *name);
 
     FILE *fp_info, *fp_warn, *fp_inside, *fp_hownear, *fp_howfar;
     FILE *fp_this_test;
@@ -109,7 +112,15 @@ private:
     EGS_BaseShape       *howfar_time_shape;
     bool                store_steps;
 
+    int                 n_bench;
+    int                 n_bench_repeat;
+    EGS_BaseShape       *bench_shape;
+    string              bench_file;
+    string              bench_label;
+
     void setTest(EGS_Input *i, const char *delim, int &n, EGS_BaseShape **s);
+    void setBenchmark(EGS_Input *i);
+    EGS_BaseShape *getTestShape(EGS_Input *i, const char *delim);
 
     int beginTest(int n, const EGS_BaseShape *s, const char *func,
                   const char *name, const EGS_BaseGeometry *g);
@@ -149,6 +160,10 @@ void EGS_GeometryTester::testHowfarTime(EGS_BaseGeometry *g) {
     p->testHowfar(g,true);
 }
 
+void EGS_GeometryTester::benchmark(EGS_BaseGeometry *g, const char *name) {
+    p->benchmark(g,name);
+}
+
 void EGS_GeometryTester::printPosition(const EGS_Vector &x) {
     fprintf(p->fp_this_test,"%g %g %g\n",x.x,x.y,x.z);
 };
@@ -172,6 +187,9 @@ EGS_PrivateTester::EGS_PrivateTester(EGS_GeometryTester *p, EGS_Input *input) {
     hownear_time_shape = 0;
     howfar_time_shape = 0;
     hownear_shape = 0;
+    n_bench = 0;
+    n_bench_repeat = 5;
+    bench_shape = 0;
     store_steps = true;
     check_infinity = true;
     fp_info = stdout;
@@ -200,6 +218,52 @@ EGS_PrivateTester::EGS_PrivateTester(EGS_GeometryTester *p, EGS_Input *input) {
 
     setTest(input,"howfar time test",n_howfar_time,&howfar_time_shape);
 
+    setBenchmark(input);
+
+}
+
+EGS_BaseShape *EGS_PrivateTester::getTestShape(EGS_Input *i,
+        const char *delim) {
+    string shape_name;
+    int ierr = i->getInput("bounding shape name",shape_name);
+    EGS_BaseShape *shape = 0;
+    if (!ierr) {
+        shape = EGS_BaseShape::getShape(shape_name);
+    }
+    if (!shape) {
+        EGS_Input *ishape = i->takeInputItem("bounding shape");
+        if (!ishape) fprintf(fp_warn,"EGS_PrivateTester::EGS_setTest: \n"
+                                 "  no 'bounding shape' definition for %s\n",delim);
+        else {
+            shape = EGS_BaseShape::createShape(ishape);
+            delete ishape;
+        }
+    }
+    if (!shape) fprintf(fp_warn,"EGS_PrivateTester::EGS_PrivateTester:"
+                            "\n  got null shape for %s\n",delim);
+    else {
+        shape->ref();
+    }
+    return shape;
+}
+
+void EGS_PrivateTester::setBenchmark(EGS_Input *input) {
+    // the benchmark is optional => no warning if missing
+    EGS_Input *i = input->takeInputItem("benchmark");
+    if (!i) {
+        return;
+    }
+    bench_shape = getTestShape(i,"benchmark");
+    int err = i->getInput("ntest",n_bench);
+    if (err) fprintf(fp_warn,"EGS_PrivateTester::setBenchmark: \n"
+                         "  missing/wrong 'ntest' input for benchmark\n");
+    err = i->getInput("nrepeat",n_bench_repeat);
+    if (err || n_bench_repeat < 1) {
+        n_bench_repeat = 5;
+    }
+    i->getInput("output file",bench_file);
+    i->getInput("label",bench_label);
+    delete i;
 }
 
 void EGS_PrivateTester::setTest(EGS_Input *input, const char *delim, int &n,
@@ -208,25 +272,8 @@ void EGS_PrivateTester::setTest(EGS_Input *input, const char *delim, int &n,
     if (!i) fprintf(fp_warn,"EGS_PrivateTester::EGS_setTest: \n"
                         "  no '%s' specification\n",delim);
     else {
-        string shape_name;
-        int ierr = i->getInput("bounding shape name",shape_name);
-        EGS_BaseShape *shape = 0;
-        if (!ierr) {
-            shape = EGS_BaseShape::getShape(shape_name);
-        }
-        if (!shape) {
-            EGS_Input *ishape = i->takeInputItem("bounding shape");
-            if (!ishape) fprintf(fp_warn,"EGS_PrivateTester::EGS_setTest: \n"
-                                     "  no 'bounding shape' definition for %s\n",delim);
-            else {
-                shape = EGS_BaseShape::createShape(ishape);
-                delete ishape;
-            }
-        }
-        if (!shape) fprintf(fp_warn,"EGS_PrivateTester::EGS_PrivateTester:"
-                                "\n  got null shape for %s\n",delim);
-        else {
-            shape->ref();
+        EGS_BaseShape *shape = getTestShape(i,delim);
+        if (shape) {
             *s = shape;
         }
         int err = i->getInput("ntest",n);
@@ -502,6 +549,146 @@ retry:
     }
 }
 
+#define N_MAX_BENCH_STEP 100000
+
+void EGS_PrivateTester::benchmark(EGS_BaseGeometry *g, const char *name) {
+    if (beginTest(n_bench,bench_shape,"benchmark()","benchmark",g)) {
+        return;
+    }
+    string gname = name ? name : g->getName();
+    fprintf(fp_info,"   repetitions: %d\n",n_bench_repeat);
+
+    // Sample all points and directions before timing anything. A fresh
+    // default generator is used so that the same rays are used for all
+    // geometries benchmarked with the same bounding shape.
+    EGS_RandomGenerator *brndm = EGS_RandomGenerator::defaultRNG();
+    EGS_Vector *xb = new EGS_Vector [n_bench];
+    EGS_Vector *ub = new EGS_Vector [n_bench];
+    int *ib = new int [n_bench];
+    for (int j=0; j<n_bench; j++) {
+        xb[j] = bench_shape->getRandomPoint(brndm);
+        EGS_Float cost = 2*brndm->getUniform()-1;
+        EGS_Float sint = sqrt(1-cost*cost);
+        EGS_Float cphi, sphi;
+        brndm->getAzimuth(cphi,sphi);
+        ub[j] = EGS_Vector(sint*cphi,sint*sphi,cost);
+        ib[j] = g->inside(xb[j]);
+    }
+    delete brndm;
+
+    const int nmethod = 3;
+    const char *methods[nmethod] = {"inside", "hownear", "howfar"};
+    double *ns = new double [nmethod*n_bench_repeat];
+    double ncall[nmethod] = {0, 0, 0};
+    int n_in = 0;
+    double sum_tperp = 0, n_howfar = 0;
+    typedef std::chrono::steady_clock Clock;
+    for (int r=0; r<n_bench_repeat; r++) {
+
+        Clock::time_point t0 = Clock::now();
+        n_in = 0;
+        for (int j=0; j<n_bench; j++) {
+            if (g->inside(xb[j]) >= 0) {
+                n_in++;
+            }
+        }
+        Clock::time_point t1 = Clock::now();
+        ncall[0] = n_bench;
+        ns[r] = std::chrono::duration<double,std::nano>(t1-t0).count()/ncall[0];
+
+        t0 = Clock::now();
+        sum_tperp = 0;
+        for (int j=0; j<n_bench; j++) {
+            sum_tperp += g->hownear(ib[j],xb[j]);
+        }
+        t1 = Clock::now();
+        ncall[1] = n_bench;
+        ns[n_bench_repeat+r] =
+            std::chrono::duration<double,std::nano>(t1-t0).count()/ncall[1];
+
+        t0 = Clock::now();
+        n_howfar = 0;
+        for (int j=0; j<n_bench; j++) {
+            EGS_Vector x(xb[j]);
+            const EGS_Vector &u = ub[j];
+            int ireg = ib[j];
+            EGS_Float t = veryFar;
+            int inew = g->howfar(ireg,x,u,t);
+            n_howfar += 1;
+            if (ireg < 0) {
+                // from outside: only continue if we enter the geometry
+                if (inew < 0) {
+                    continue;
+                }
+                x += u*t;
+                ireg = inew;
+                t = veryFar;
+                inew = g->howfar(ireg,x,u,t);
+                n_howfar += 1;
+            }
+            int nstep = 0;
+            // inew == ireg means that we are in an infinite region
+            // and never get out.
+            while (inew != ireg && inew >= 0 && ++nstep < N_MAX_BENCH_STEP) {
+                x += u*t;
+                ireg = inew;
+                t = veryFar;
+                inew = g->howfar(ireg,x,u,t);
+                n_howfar += 1;
+            }
+        }
+        t1 = Clock::now();
+        ncall[2] = n_howfar;
+        ns[2*n_bench_repeat+r] = n_howfar > 0 ?
+                                 std::chrono::duration<double,std::nano>(t1-t0).count()/n_howfar : 0;
+    }
+    fprintf(fp_info,"   points inside: %d (%g)\n",n_in,
+            ((double) n_in)/((double) n_bench));
+    fprintf(fp_info,"   average tperp: %g\n",sum_tperp/n_bench);
+    fprintf(fp_info,"   average number of howfar calls per ray: %g\n",
+            n_howfar/n_bench);
+
+    FILE *fp_bench = 0;
+    if (bench_file.size() > 0) {
+        fp_bench = fopen(bench_file.c_str(),"a");
+        if (!fp_bench) fprintf(fp_warn,"EGS_GeometryTester::benchmark: "
+                                   "failed to open file %s for writing\n",bench_file.c_str());
+        else if (fseek(fp_bench,0,SEEK_END) == 0 && ftell(fp_bench) == 0) {
+            fprintf(fp_bench,"label,geometry,type,method,ntest,nrepeat,calls,"
+                    "ns_per_call,ns_sd,calls_per_s\n");
+        }
+    }
+    fprintf(fp_info,"   %-8s %14s %12s %10s %14s\n","method","calls",
+            "ns/call","sd","calls/s");
+    for (int m=0; m<nmethod; m++) {
+        double sum = 0, sum2 = 0;
+        for (int r=0; r<n_bench_repeat; r++) {
+            double t = ns[m*n_bench_repeat+r];
+            sum += t;
+            sum2 += t*t;
+        }
+        double mean = sum/n_bench_repeat, sd = 0;
+        if (n_bench_repeat > 1) {
+            sd = (sum2 - sum*mean)/(n_bench_repeat-1);
+            sd = sd > 0 ? sqrt(sd) : 0;
+        }
+        double rate = mean > 0 ? 1e9/mean : 0;
+        fprintf(fp_info,"   %-8s %14.0f %12.2f %10.2f %14.4g\n",methods[m],
+                ncall[m],mean,sd,rate);
+        if (fp_bench) {
+            fprintf(fp_bench,"%s,%s,%s,%s,%d,%d,%.0f,%.4f,%.4f,%.6g\n",
+                    bench_label.c_str(),gname.c_str(),g->getType().c_str(),
+                    methods[m],n_bench,n_bench_repeat,ncall[m],mean,sd,rate);
+        }
+    }
+    if (fp_bench) {
+        fclose(fp_bench);
+    }
+    delete [] ns;
+    delete [] ib;
+    delete [] ub;
+    delete [] xb;
+}
 
 int EGS_PrivateTester::beginTest(int n, const EGS_BaseShape *s,
                                  const char *func, const char *name, const EGS_BaseGeometry *g) {
@@ -53,7 +53,10 @@ class EGS_BaseGeometry;
   geometry classes. The various tests available are described
   in the documentation of the testing functions
   testInside(), testInsideTime(), testHowfar(), testHowfarTime(),
-  testHownear(), and testHownearTime().
+  testHownear(), and testHownearTime(). In addition, benchmark() measures
+  the time per call of the inside(), hownear() and howfar() methods and
+  writes the results in a machine-readable form, so that the performance
+  of geometries can be compared between versions.
   As the geometry to be tested will be typically defined  via an input
   file, we use the same input file to also specify the tests to be run
   => EGS_GeometryTester::EGS_GeometryTester(EGS_Input *)
@@ -184,6 +187,43 @@ public:
      */
     void testHowfarTime(EGS_BaseGeometry *);
 
+    /*! \brief Benchmarks the inside(), hownear() and howfar() methods of
+      the geometry \a g.
+
+      \a ntest random points and directions are sampled within the bounding
+      shape using a freshly initialized default random number generator
+      (see EGS_RandomGenerator::defaultRNG()), so that all geometries
+      benchmarked with the same bounding shape see the same ray
+      distribution. The points and directions are sampled before
+      any timing starts. Each repetition then times
+      - \c inside: one inside() call per point
+      - \c hownear: one hownear() call per point, using the region of the point
+      - \c howfar: each ray is tracked through the geometry
+        until it exits (or misses) the geometry. The time is divided by the
+        total number of howfar() calls.
+
+      The average time per call (in ns), its standard deviation over the
+      repetitions and the number of calls per second are printed. If an
+      output file is specified, one line per method is appended to it
+      in comma separated format with the columns
+      \verbatim
+      label,geometry,type,method,ntest,nrepeat,calls,ns_per_call,ns_sd,calls_per_s
+      \endverbatim
+      (a header line is written if the file is empty). \a name is used
+      for the \c geometry column if not null, otherwise the geometry name
+      is used. The benchmark is defined in the input of the geometry tester
+      \verbatim
+      :start benchmark:
+          bounding shape definition (same as for the inside test)
+          ntest = number of points/rays per repetition
+          nrepeat = number of repetitions (optional, default is 5)
+          output file = file name (optional)
+          label = a label for this run, e.g. a version (optional)
+      :stop benchmark:
+      \endverbatim
+     */
+    void benchmark(EGS_BaseGeometry *g, const char *name = 0);
+
     /*! \brief Outputs the position \a x to a file
 
       This function is called from the various testing methods to print
@@ -220,7 +260,8 @@ public:
       \link testHowfar() howfar\endlink,
       \link testHowfarTime() howfar time\endlink,
       \link testHownear() hownear\endlink,
-      \link testHownearTime() hownear time\endlink).
+      \link testHownearTime() hownear time\endlink,
+      \link benchmark() benchmark\endlink).
       The \c output \c type key is optional and results in a "normal"
       output, if missing. The type of output determines how the positions
       of the points in the various tests are written to the file:
@@ -0,0 +1,297 @@
+/*
+###############################################################################
+#
+#  EGSnrc egs++ instrumentation counters headers
+#  Copyright (C) 2015 National Research Council Canada
+#
+#  This file is part of EGSnrc.
+#
+#  EGSnrc is free software: you can redistribute it and/or modify it under
+#  the terms of the GNU Affero General Public License as published by the
+#  Free Software Foundation, either version 3 of the License, or (at your
+#  option) any later version.
+#
+#  EGSnrc is distributed in the hope that it will be useful, but WITHOUT ANY
+#  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+#  FOR A PARTICULAR PURPOSE.  See the GNU Affero General Public License for
+#  more details.
+#
+#  You should have received a copy of the GNU Affero General Public License
+#  along with EGSnrc. If not, see <http://www.gnu.org/licenses/>.
+#
+###############################################################################
+*/
+
+
+/*! \file egs_instrumentation.h
+ *  \brief EGS_Instrumentation class header file
+ */
+
+#ifndef EGS_INSTRUMENTATION_
+#define EGS_INSTRUMENTATION_
+
+#include "egs_libconfig.h"
+#include "egs_functions.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <iostream>
+
+using namespace std;
+
+/*! \brief Only every EGS_INSTRUMENT_SAMPLE'th call of a component is timed.
+
+  Must be a power of 2. Reading the clock costs about as much as a simple
+  howfar() call, so timing every call would distort the results.
+ */
+#ifndef EGS_INSTRUMENT_SAMPLE
+    #define EGS_INSTRUMENT_SAMPLE 16
+#endif
+
+/*! \brief Call counters and sampled timings for the hot paths of an
+  EGS_Application.
+
+  \ingroup egspp_main
+
+  The instrumentation is compiled in only if the macro \c EGS_INSTRUMENT is
+  defined when compiling the egs++ library <b>and</b> the application
+  (\em e.g. by adding <code>-DEGS_INSTRUMENT</code> to the \c opt variable
+  of the egs++ configuration). Otherwise EGS_Application never creates an
+  EGS_Instrumentation object and the EGS_INSTRUMENT_CALL() and
+  EGS_INSTRUMENT_AUSGAB() macros compile to nothing.
+
+  When compiled in, the application counts the calls to the geometry
+  (EGS_Application::howfar(), EGS_Application::hownear() and
+  isWhere()), to the source (getNextParticle()), to the shower() function
+  (the mortran transport for EGS_AdvancedApplication), to the
+  processEvent() method of each ausgab object and to ausgab(). Every
+  EGS_INSTRUMENT_SAMPLE'th call is timed. The total time of each component
+  is estimated from the timed calls. The breakdown is printed at the end of
+  the simulation and is stored in the .egsdat file, so that the
+  breakdowns of parallel jobs are summed when the results are combined.
+  The time for shower() includes the geometry and ausgab calls made during
+  transport. The report therefore also lists the difference, which is the
+  time spent in physics and particle bookkeeping.
+
+  Note that .egsdat files written by an instrumented build can only be
+  read back by an instrumented build.
+ */
+class EGS_Instrumentation {
+
+public:
+
+    enum Component { Source, IsWhere, Howfar, Hownear, Shower, Ausgab,
+                     NComponent
+                   };
+
+    /*! \brief A call counter with sampled timing */
+    struct Counter {
+        EGS_I64 ncall;   //!< number of calls
+        EGS_I64 ntimed;  //!< number of timed calls
+        double  time;    //!< time spent in the timed calls (seconds)
+        Counter() : ncall(0), ntimed(0), time(0) {};
+        void reset() {
+            ncall = 0;
+            ntimed = 0;
+            time = 0;
+        };
+        /*! \brief The estimated total time spent in this component */
+        double estimatedTime() const {
+            return ntimed > 0 ? time*ncall/ntimed : 0;
+        };
+    };
+
+    EGS_Instrumentation() {};
+
+    Counter *counter(Component c) {
+        return &counters[c];
+    };
+
+    /*! \brief Registers the ausgab object \a o with name \a name */
+    void addAusgabObject(const void *o, const string &name) {
+        a_objects.push_back(o);
+        a_names.push_back(name);
+        a_counters.push_back(Counter());
+    };
+
+    /*! \brief The counter of the ausgab object \a o (0 if not registered) */
+    Counter *ausgabCounter(const void *o) {
+        for (size_t j=0; j<a_objects.size(); ++j) {
+            if (a_objects[j] == o) {
+                return &a_counters[j];
+            }
+        }
+        return 0;
+    };
+
+    void resetCounter() {
+        for (int j=0; j<NComponent; ++j) {
+            counters[j].reset();
+        }
+        for (size_t j=0; j<a_counters.size(); ++j) {
+            a_counters[j].reset();
+        }
+    };
+
+    bool storeState(ostream &data) const {
+        data << "EGS_Instrumentation " << a_counters.size() << endl;
+        for (int j=0; j<NComponent; ++j) {
+            if (!storeCounter(data,counters[j])) {
+                return false;
+            }
+        }
+        for (size_t j=0; j<a_counters.size(); ++j) {
+            if (!storeCounter(data,a_counters[j])) {
+                return false;
+            }
+        }
+        return data.good();
+    };
+
+    /*! \brief Adds the counters stored in \a data.
+
+      Returns false and leaves \a data unchanged if \a data does not
+      contain instrumentation counters at the current position.
+     */
+    bool addState(istream &data) {
+        streampos pos = data.tellg();
+        string marker;
+        int na = -1;
+        data >> marker >> na;
+        if (!data.good() || marker != "EGS_Instrumentation" ||
+                na != (int)a_counters.size()) {
+            data.clear();
+            data.seekg(pos);
+            return false;
+        }
+        for (int j=0; j<NComponent; ++j) {
+            if (!addCounter(data,counters[j])) {
+                return false;
+            }
+        }
+        for (size_t j=0; j<a_counters.size(); ++j) {
+            if (!addCounter(data,a_counters[j])) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    /*! \brief Prints the breakdown. \a cpu is the total CPU time of the run */
+    void report(double cpu) const {
+        static const char *names[NComponent] = {
+            "source getNextParticle", "geometry isWhere",
+            "geometry howfar", "geometry hownear",
+            "shower (transport)", "ausgab"
+        };
+        egsInformation("\n\nInstrumentation (every %d'th call timed)\n"
+                       "=======================================================================\n",
+                       EGS_INSTRUMENT_SAMPLE);
+        egsInformation("%-30s %14s %10s %10s %7s\n","component","calls",
+                       "ns/call","time (s)","% cpu");
+        double t_in_shower = 0;
+        for (int j=0; j<NComponent; ++j) {
+            printCounter(names[j],counters[j],cpu);
+            if (j == Howfar || j == Hownear || j == Ausgab) {
+                t_in_shower += counters[j].estimatedTime();
+            }
+        }
+        for (size_t j=0; j<a_counters.size(); ++j) {
+            string name = "ausgab object " + a_names[j];
+            printCounter(name.c_str(),a_counters[j],cpu);
+            t_in_shower += a_counters[j].estimatedTime();
+        }
+        double t_physics = counters[Shower].estimatedTime() - t_in_shower;
+        if (counters[Shower].ncall > 0 && t_physics > 0) {
+            egsInformation("%-30s %14s %10s %10.3f %7.2f\n",
+                           "shower excl. geometry/ausgab","","",t_physics,
+                           cpu > 0 ? 100*t_physics/cpu : 0.);
+        }
+        egsInformation(
+            "=======================================================================\n");
+    };
+
+private:
+
+    static bool storeCounter(ostream &data, const Counter &c) {
+        if (!egsStoreI64(data,c.ncall) || !egsStoreI64(data,c.ntimed)) {
+            return false;
+        }
+        data << "  " << c.time << endl;
+        return data.good();
+    };
+
+    static bool addCounter(istream &data, Counter &c) {
+        EGS_I64 ncall, ntimed;
+        double time;
+        if (!egsGetI64(data,ncall) || !egsGetI64(data,ntimed)) {
+            return false;
+        }
+        data >> time;
+        if (!data.good()) {
+            return false;
+        }
+        c.ncall += ncall;
+        c.ntimed += ntimed;
+        c.time += time;
+        return true;
+    };
+
+    static void printCounter(const char *name, const Counter &c, double cpu) {
+        if (!c.ncall) {
+            return;
+        }
+        double t = c.estimatedTime();
+        egsInformation("%-30s %14lld %10.1f %10.3f %7.2f\n",name,c.ncall,
+                       c.ntimed > 0 ? 1e9*c.time/c.ntimed : 0.,t,
+                       cpu > 0 ? 100*t/cpu : 0.);
+    };
+
+    Counter          counters[NComponent];
+    vector<const void *> a_objects;
+    vector<string>   a_names;
+    vector<Counter>  a_counters;
+};
+
+/*! \brief Counts (and every EGS_INSTRUMENT_SAMPLE'th time times) the
+  enclosing scope using the counter \a c, if \a c is not null.
+ */
+class EGS_InstrumentationScope {
+public:
+    EGS_InstrumentationScope(EGS_Instrumentation::Counter *C) : c(C),
+        timed(false) {
+        if (c && !((c->ncall++) & (EGS_INSTRUMENT_SAMPLE-1))) {
+            timed = true;
+            t0 = std::chrono::steady_clock::now();
+        }
+    };
+    ~EGS_InstrumentationScope() {
+        if (timed) {
+            c->time += std::chrono::duration<double>(
+                           std::chrono::steady_clock::now()-t0).count();
+            c->ntimed++;
+        }
+    };
+private:
+    EGS_Instrumentation::Counter *c;
+    bool timed;
+    std::chrono::steady_clock::time_point t0;
+};
+
+#ifdef EGS_INSTRUMENT
+    /*! \brief Instruments the enclosing scope as component \a comp.
+        For use in EGS_Application member functions only. */
+    #define EGS_INSTRUMENT_CALL(comp) \
+        EGS_InstrumentationScope egs_instrument_scope(instrumentation ? \
+            instrumentation->counter(EGS_Instrumentation::comp) : 0)
+    /*! \brief Instruments the enclosing scope as a call to ausgab object \a o */
+    #define EGS_INSTRUMENT_AUSGAB(o) \
+        EGS_InstrumentationScope egs_instrument_ausgab(instrumentation ? \
+            instrumentation->ausgabCounter(o) : 0)
+#else
+    #define EGS_INSTRUMENT_CALL(comp)
+    #define EGS_INSTRUMENT_AUSGAB(o)
+#endif
+
+#endif
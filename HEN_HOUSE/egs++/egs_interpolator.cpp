@@ -197,3 +197,53 @@ void EGS_Interpolator::initialize(EGS_Float Xmin, EGS_Float Xmax,
     }
     initialize(nmax,Xmin,Xmax,func,data);
 }
+
+EGS_MultiInterpolator::EGS_MultiInterpolator() : nmed(0), n(0), ab(0) {}
+
+EGS_MultiInterpolator::EGS_MultiInterpolator(int Nmed,
+        const EGS_Interpolator *interp) : nmed(0), n(0), ab(0) {
+    initialize(Nmed,interp);
+}
+
+EGS_MultiInterpolator::~EGS_MultiInterpolator() {
+    clear();
+}
+
+void EGS_MultiInterpolator::clear() {
+    if (ab) {
+        delete [] ab;
+        ab = 0;
+    }
+    nmed = 0;
+    n = 0;
+}
+
+bool EGS_MultiInterpolator::initialize(int Nmed,
+                                       const EGS_Interpolator *interp) {
+    clear();
+    if (Nmed < 1 || !interp || interp[0].n < 1) {
+        return false;
+    }
+    for (int m=1; m<Nmed; m++) {
+        if (interp[m].n != interp[0].n || interp[m].xmin != interp[0].xmin ||
+                interp[m].xmax != interp[0].xmax) {
+            return false;
+        }
+    }
+    n = interp[0].n;
+    ax = interp[0].ax;
+    bx = interp[0].bx;
+    xmin = interp[0].xmin;
+    xmax = interp[0].xmax;
+    // There are n+1 coefficients per interpolator, the last one
+    // covering x = xmax.
+    ab = new EGS_Float [2*(n+1)*Nmed];
+    for (int i=0; i<=n; i++) {
+        for (int m=0; m<Nmed; m++) {
+            ab[2*(i*Nmed+m)]   = interp[m].a[i];
+            ab[2*(i*Nmed+m)+1] = interp[m].b[i];
+        }
+    }
+    nmed = Nmed;
+    return true;
+}
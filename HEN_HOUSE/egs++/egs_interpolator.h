@@ -223,6 +223,35 @@ public:
         return a[i] + b[i]*x;
     };
 
+    /*! \brief Interpolate the \a np values \a x and store the results in \a f.
+
+      Equivalent to calling interpolate() for each element of \a x, but
+      the index calculation and coefficient look-up are done in a simple
+      loop without branches that the compiler can vectorize. \a f may be
+      the same array as \a x.
+    */
+    void interpolate(int np, const EGS_Float *x, EGS_Float *f) const {
+        for (int j=0; j<np; j++) {
+            EGS_Float xj = x[j] > xmin ? (x[j] < xmax ? x[j] : xmax) : xmin;
+            int i = (int)(ax + bx*xj);
+            i = i < 0 ? 0 : (i > n ? n : i);
+            EGS_Float res = a[i] + b[i]*xj;
+            f[j] = x[j] > xmin ? (x[j] < xmax ? res : fmax) : fmin;
+        }
+    };
+
+    /*! \brief Interpolate the \a np values \a x and store the results in \a f.
+
+      Equivalent to calling interpolateFast() for each element of \a x, so
+      all \a x must be in the interpolation interval.
+    */
+    void interpolateFast(int np, const EGS_Float *x, EGS_Float *f) const {
+        for (int j=0; j<np; j++) {
+            int i = (int)(ax + bx*x[j]);
+            f[j] = a[i] + b[i]*x[j];
+        }
+    };
+
     /*! \brief Get the lower interpolation interval limit. */
     EGS_Float getXmin() const {
         return xmin;
@@ -243,6 +272,8 @@ public:
 
 private:
 
+    friend class EGS_MultiInterpolator;
+
     int            n;     //!< number of bins
     EGS_Float ax, bx;     //!< convert x to an index.
     EGS_Float *a, *b;     //!< interpolation coefficients.
@@ -254,4 +285,112 @@ private:
     void check(int nbin, EGS_Float Xmin, EGS_Float Xmax);
 };
 
+/*! \brief Interpolation of a quantity for several media at once.
+
+  \ingroup egspp_main
+
+  Stores the interpolation coefficients of a set of EGS_Interpolator
+  objects that use the same interpolation interval and number of bins,
+  \em e.g. the photon mean free path of all media, such that the
+  coefficients of all media for a given bin are stored contiguously.
+  When a ray is traced through a geometry with many media at a fixed
+  energy, the interpolation index only needs to be computed once with
+  getIndexFast() and the coefficients for all media encountered along
+  the ray come from the same one or two cache lines. The results are
+  identical to the ones of the individual interpolators.
+*/
+class EGS_EXPORT EGS_MultiInterpolator {
+
+public:
+
+    /*! \brief Create an empty (unitialized) interpolator */
+    EGS_MultiInterpolator();
+
+    /*! \brief Create a multi-medium interpolator from the \a nmed
+      interpolators \a interp
+
+      Use isValid() to check if this was successful.
+    */
+    EGS_MultiInterpolator(int nmed, const EGS_Interpolator *interp);
+
+    ~EGS_MultiInterpolator();
+
+    /*! \brief Initialize from the \a nmed interpolators \a interp.
+
+      Returns \c false and leaves the object uninitialized if there are no
+      interpolators or if they do not all use the same interpolation
+      interval and number of bins.
+    */
+    bool initialize(int nmed, const EGS_Interpolator *interp);
+
+    /*! \brief Is this interpolator initialized? */
+    bool isValid() const {
+        return nmed > 0;
+    };
+
+    /*! \brief Number of media */
+    int nMedia() const {
+        return nmed;
+    };
+
+    /*! \brief Get the interpolation index for \a x.
+
+      Same as EGS_Interpolator::getIndexFast() of the individual
+      interpolators.
+    */
+    inline int getIndexFast(EGS_Float x) const {
+        return (int)(ax + bx*x);
+    };
+
+    /*! \brief Get the interpolation index for \a x, checking the limits. */
+    inline int getIndex(EGS_Float x) const {
+        if (x > xmin && x < xmax) {
+            return (int)(ax + bx*x);
+        }
+        else if (x <= xmin) {
+            return 0;
+        }
+        else {
+            return n-1;
+        }
+    };
+
+    /*! \brief Interpolate medium \a imed at \a x using the interpolation
+      index \a i from getIndexFast().
+    */
+    inline EGS_Float interpolateFast(int i, int imed, EGS_Float x) const {
+        const EGS_Float *c = ab + 2*(i*nmed + imed);
+        return c[0] + c[1]*x;
+    };
+
+    /*! \brief Interpolate medium \a imed at \a x (no limit checks). */
+    inline EGS_Float interpolateFast(int imed, EGS_Float x) const {
+        return interpolateFast(getIndexFast(x),imed,x);
+    };
+
+    /*! \brief Interpolate all media at \a x using the interpolation
+      index \a i from getIndexFast() and store the results in \a f.
+    */
+    void interpolateAll(int i, EGS_Float x, EGS_Float *f) const {
+        const EGS_Float *c = ab + 2*i*nmed;
+        for (int m=0; m<nmed; m++) {
+            f[m] = c[2*m] + c[2*m+1]*x;
+        }
+    };
+
+private:
+
+    int       nmed;       //!< number of media
+    int       n;          //!< number of bins
+    EGS_Float ax, bx;     //!< convert x to an index.
+    EGS_Float xmin, xmax; //!< interpolation interval.
+    EGS_Float *ab;        //!< coefficients, a and b for all media per bin
+
+    void clear();
+
+    /*! Not implemented: ab is owned, copies would delete it twice */
+    EGS_MultiInterpolator(const EGS_MultiInterpolator &);
+    EGS_MultiInterpolator &operator=(const EGS_MultiInterpolator &);
+};
+
 #endif
@@ -55,8 +55,8 @@ vector<EGS_Library *> rc_libs;
 static int n_run_controls = 0;
 
 EGS_RunControl::EGS_RunControl(EGS_Application *a) : geomErrorCount(0),
-    geomErrorMax(0), app(a), input(0), ncase(0), ndone(0), maxt(-1), accu(-1),
-    nbatch(10), restart(0), nchunk(1), cpu_time(0), previous_cpu_time(0),
+    geomErrorMax(0), timeBlockSize(0), app(a), input(0), ncase(0), ndone(0),
+    maxt(-1), accu(-1), nbatch(10), restart(0), nchunk(1), cpu_time(0), previous_cpu_time(0),
     rco_type(simple) {
     n_run_controls++;
     if (!app) egsFatal("EGS_RunControl::EGS_RunControl: it is not allowed\n"
@@ -107,6 +107,10 @@ EGS_RunControl::EGS_RunControl(EGS_Application *a) : geomErrorCount(0),
     if (err) {
         geomErrorMax = 0;
     }
+    err = input->getInput("time sorted block size", timeBlockSize);
+    if (err || timeBlockSize < 0) {
+        timeBlockSize = 0;
+    }
 
     vector<string> ctype;
     ctype.push_back("first");
@@ -846,6 +850,25 @@ int EGS_RunControl::finishSimulation() {
     //        all_steps);
     egsInformation("%-40s","Number of all electron steps:");
     egsInformation("%-14g\n",all_steps);
+    // ndone and the step counts include previous runs when restarting or
+    // combining, so both rates use the CPU time including previous runs
+    EGS_Float total_cpu_time = cpu_time + previous_cpu_time;
+    if (total_cpu_time > 0) {
+        egsInformation("%-40s%-14g\n","Histories per second:",
+                       ndone/total_cpu_time);
+        egsInformation("%-40s%-14g\n","Electron steps per second:",
+                       all_steps/total_cpu_time);
+    }
+    int stack_size = app->getStackSize();
+    if (stack_size > 0 && app->Np_max >= 0) {
+        egsInformation("%-40s%d (of %d)\n","Maximum particle stack depth:",
+                       app->Np_max+1,stack_size);
+    }
+    long peak_mem = egsPeakMemory();
+    if (peak_mem > 0) {
+        egsInformation("%-40s%.1f (MB)\n","Peak resident memory:",
+                       peak_mem/1024.);
+    }
 
     int n_par   = app->getNparallel(),
         i_par   = app->getIparallel(),
@@ -132,6 +132,11 @@ public:
         accu = a;
     };
 
+    /*! \brief Returns the required statistical uncertainty (<= 0 if none) */
+    EGS_Float getRequiredUncertainty() const {
+        return accu;
+    };
+
     /*! \brief Returns the total number of particles to be simulated */
     EGS_I64 getNcase() const {
         return ncase;
@@ -233,6 +238,13 @@ public:
 
     int             geomErrorCount, geomErrorMax;
 
+    /*! \brief Number of time indices sampled and sorted at once
+      (0: each history samples its own time index).
+
+      See EGS_Application::getNextTimeIndex().
+    */
+    int             timeBlockSize;
+
 protected:
 
     EGS_Application *app;
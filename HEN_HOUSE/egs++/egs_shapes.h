@@ -170,9 +170,11 @@ public:
      */
     void setTransformation(EGS_AffineTransform *t) {
         if (T) {
-            delete T;
+            *T = *t;
+        }
+        else {
+            T = new EGS_AffineTransform(*t);
         }
-        T = new EGS_AffineTransform(*t);
     };
 
     /*! \brief Get a pointer to the affine transformation attached to this
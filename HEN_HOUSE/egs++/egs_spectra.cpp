@@ -431,6 +431,10 @@ protected:
         return table->sample(rndm);
     };
 
+    void sampleBatch(EGS_RandomGenerator *rndm, int n, EGS_Float *E) {
+        table->sample(rndm,n,E);
+    };
+
 };
 
 //
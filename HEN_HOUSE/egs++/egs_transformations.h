@@ -418,6 +418,15 @@ public:
   \f$T \vec{x} = R \vec{x} + \vec{t}\f$. See the getTransformation()
   documentation for description of the keys needed to define
   an affine transformation.
+
+  The transformation classifies itself when constructed: the translation
+  and the rotation are skipped when they are not needed, and a rotation
+  around one of the coordinate axes is applied using only the 4
+  non-trivial matrix elements. The transform(), inverseTransform(), rotate()
+  and rotateInverse() methods, which are used for every step in transformed
+  geometries and for every particle of transformed sources and shapes,
+  dispatch to the corresponding code. Versions of these methods for
+  arrays of vectors make the dispatch once for the whole array.
  */
 class EGS_EXPORT EGS_AffineTransform {
 
@@ -426,15 +435,90 @@ protected:
     EGS_RotationMatrix R;
     EGS_Vector         t;
     bool               has_t, has_R;
+    /*! \brief The coordinate axis (0, 1 or 2 for x, y or z) \a R rotates
+      around, or -1 for a general rotation.
+
+      Derived classes that modify \a R directly must leave this at -1 or
+      call setRotationAxis(). */
+    int                axis;
+
+    /*! \brief Sets #axis from the rotation matrix \a R.
+
+      Only matrices with exact zeros and an exact 1 in the row and column
+      of an axis are classified as axis rotations, so that the
+      specialized code gives the same result as the full matrix product.
+     */
+    void setRotationAxis() {
+        axis = -1;
+        if (!has_R) {
+            return;
+        }
+        if (R.xx() == 1 && R.xy() == 0 && R.xz() == 0 && R.yx() == 0 &&
+                R.zx() == 0) {
+            axis = 0;
+        }
+        else if (R.yy() == 1 && R.yx() == 0 && R.yz() == 0 &&
+                 R.xy() == 0 && R.zy() == 0) {
+            axis = 1;
+        }
+        else if (R.zz() == 1 && R.zx() == 0 && R.zy() == 0 &&
+                 R.xz() == 0 && R.yz() == 0) {
+            axis = 2;
+        }
+    };
+
+    /*! \brief Multiplies \f$(a,b)\f$ with the 2x2 matrix
+      \f$((m_{11},m_{12}),(m_{21},m_{22}))\f$ */
+    static void rotate2D(EGS_Float &a, EGS_Float &b, EGS_Float m11,
+                         EGS_Float m12, EGS_Float m21, EGS_Float m22) {
+        EGS_Float a1 = a;
+        a = m11*a1 + m12*b;
+        b = m21*a1 + m22*b;
+    };
+
+    /*! \brief Rotates \a v with \a R, which must not be the unit matrix */
+    void applyR(EGS_Vector &v) const {
+        switch (axis) {
+        case 0:
+            rotate2D(v.y,v.z,R.yy(),R.yz(),R.zy(),R.zz());
+            break;
+        case 1:
+            rotate2D(v.x,v.z,R.xx(),R.xz(),R.zx(),R.zz());
+            break;
+        case 2:
+            rotate2D(v.x,v.y,R.xx(),R.xy(),R.yx(),R.yy());
+            break;
+        default:
+            v = R*v;
+        }
+    };
+
+    /*! \brief Rotates \a v with the inverse of \a R, which must not be
+      the unit matrix */
+    void applyRInverse(EGS_Vector &v) const {
+        switch (axis) {
+        case 0:
+            rotate2D(v.y,v.z,R.yy(),R.zy(),R.yz(),R.zz());
+            break;
+        case 1:
+            rotate2D(v.x,v.z,R.xx(),R.zx(),R.xz(),R.zz());
+            break;
+        case 2:
+            rotate2D(v.x,v.y,R.xx(),R.yx(),R.xy(),R.yy());
+            break;
+        default:
+            v *= R;
+        }
+    };
 
 public:
 
     /*! \brief Constructs a unit affine transformation */
-    EGS_AffineTransform() : R(),t(),has_t(false),has_R(false) {};
+    EGS_AffineTransform() : R(),t(),has_t(false),has_R(false),axis(-1) {};
 
     /*! \brief Copy constructor */
     EGS_AffineTransform(const EGS_AffineTransform &tr) :
-        R(tr.R),t(tr.t),has_t(tr.has_t),has_R(tr.has_R) {};
+        R(tr.R),t(tr.t),has_t(tr.has_t),has_R(tr.has_R),axis(tr.axis) {};
 
     /*! \brief Constructs an affine transformation object from the rotation
       \a m and translation \a v. */
@@ -452,6 +536,7 @@ public:
         else {
             has_R = true;
         }
+        setRotationAxis();
     };
 
     /*! \brief Constructs an affine transformation object from the rotation
@@ -464,11 +549,12 @@ public:
         else {
             has_R = true;
         }
+        setRotationAxis();
     };
 
     /*! \brief Constructs an affine transformation object from the translation
       \a v, which has no rotation. */
-    EGS_AffineTransform(const EGS_Vector &v) : R(),t(v) {
+    EGS_AffineTransform(const EGS_Vector &v) : R(),t(v),axis(-1) {
         has_R = false;
         if (t.length2() > 0) {
             has_t = true;
@@ -522,6 +608,7 @@ public:
 
     EGS_AffineTransform &operator+=(const EGS_Vector &v) {
         t += v;
+        has_t = t.length2() > 0;
         return *this;
     };
 
@@ -550,24 +637,48 @@ public:
     /*! \brief Transforms the vector \a v */
     void transform(EGS_Vector &v) const {
         if (has_R) {
-            v = R*v;
+            applyR(v);
         }
         if (has_t) {
             v += t;
         }
     };
 
+    /*! \brief Transforms the \a n vectors \a v */
+    void transform(int n, EGS_Vector *v) const {
+        if (has_R) {
+            rotate(n,v);
+        }
+        if (has_t) {
+            for (int j=0; j<n; ++j) {
+                v[j] += t;
+            }
+        }
+    };
+
     /*! \brief Applies the inverse transformation to the vector \a v */
     void inverseTransform(EGS_Vector &v) const {
         if (has_t) {
             v -= t;
         }
         if (has_R) {
-            v *= R;
+            applyRInverse(v);
         }
         //v -= t; v *= R;
     };
 
+    /*! \brief Applies the inverse transformation to the \a n vectors \a v */
+    void inverseTransform(int n, EGS_Vector *v) const {
+        if (has_t) {
+            for (int j=0; j<n; ++j) {
+                v[j] -= t;
+            }
+        }
+        if (has_R) {
+            rotateInverse(n,v);
+        }
+    };
+
     /*! \brief Returns the inverse affine transformation */
     EGS_AffineTransform inverse() const {
         EGS_Vector tmp;
@@ -578,13 +689,69 @@ public:
     /*! \brief Applies the rotation to the vector \a v */
     void rotate(EGS_Vector &v) const {
         if (has_R) {
-            v = R*v;
+            applyR(v);
+        }
+    };
+    /*! \brief Applies the rotation to the \a n vectors \a v */
+    void rotate(int n, EGS_Vector *v) const {
+        if (!has_R) {
+            return;
+        }
+        int j;
+        switch (axis) {
+        case 0:
+            for (j=0; j<n; ++j) {
+                rotate2D(v[j].y,v[j].z,R.yy(),R.yz(),R.zy(),R.zz());
+            }
+            break;
+        case 1:
+            for (j=0; j<n; ++j) {
+                rotate2D(v[j].x,v[j].z,R.xx(),R.xz(),R.zx(),R.zz());
+            }
+            break;
+        case 2:
+            for (j=0; j<n; ++j) {
+                rotate2D(v[j].x,v[j].y,R.xx(),R.xy(),R.yx(),R.yy());
+            }
+            break;
+        default:
+            for (j=0; j<n; ++j) {
+                v[j] = R*v[j];
+            }
         }
     };
     /*! \brief Applies the inverse rotation to the vector \a v */
     void rotateInverse(EGS_Vector &v) const {
         if (has_R) {
-            v *= R;
+            applyRInverse(v);
+        }
+    };
+    /*! \brief Applies the inverse rotation to the \a n vectors \a v */
+    void rotateInverse(int n, EGS_Vector *v) const {
+        if (!has_R) {
+            return;
+        }
+        int j;
+        switch (axis) {
+        case 0:
+            for (j=0; j<n; ++j) {
+                rotate2D(v[j].y,v[j].z,R.yy(),R.zy(),R.yz(),R.zz());
+            }
+            break;
+        case 1:
+            for (j=0; j<n; ++j) {
+                rotate2D(v[j].x,v[j].z,R.xx(),R.zx(),R.xz(),R.zz());
+            }
+            break;
+        case 2:
+            for (j=0; j<n; ++j) {
+                rotate2D(v[j].x,v[j].y,R.xx(),R.yx(),R.xy(),R.yy());
+            }
+            break;
+        default:
+            for (j=0; j<n; ++j) {
+                v[j] *= R;
+            }
         }
     };
     /*! \brief Applies the translation to the vector \a v */
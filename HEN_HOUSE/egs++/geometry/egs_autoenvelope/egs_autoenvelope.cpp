@@ -45,6 +45,7 @@
  */
 
 #include "egs_input.h"
+#include "egs_application.h"
 #include "egs_autoenvelope.h"
 #include "../egs_gtransformed/egs_gtransformed.h"
 
@@ -53,6 +54,8 @@
 #include <numeric>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <cstdio>
 
 #ifdef HAS_SOBOL
     #include "sobol.h"
@@ -135,13 +138,28 @@ EGS_AEnvelope::EGS_AEnvelope(EGS_BaseGeometry *base_geom,
 
     geoms_in_region = new vector<EGS_BaseGeometry *>[nregbase];
 
-    if (inscribed[0].vcopts->vc_file != "") {
-        vc_results = loadFileResults(inscribed[0].vcopts, base_geom, inscribed_geoms, transforms);
-        egsInformation("loaded from %s\n", inscribed[0].vcopts->vc_file.c_str());
+    // with caching requested, reuse the results of a previous run for the
+    // same inputs if available
+    string cache_file;
+    VCOptions *vcopts = inscribed[0].vcopts;
+    if (vcopts->vc_file == "" && vcopts->use_cache) {
+        cache_file = base_geom->getName() + ".autoenv." +
+                     getVCHash(vcopts, base_geom, inscribed_geoms, transforms) + ".volcor";
+        ifstream cached(cache_file.c_str());
+        if (cached.is_open()) {
+            cached.close();
+            vcopts->vc_file = cache_file;
+            cache_file = "";
+        }
+    }
+
+    if (vcopts->vc_file != "") {
+        vc_results = loadFileResults(vcopts, base_geom, inscribed_geoms, transforms);
+        egsInformation("loaded from %s\n", vcopts->vc_file.c_str());
     }
     else {
         // now run volume correction and figure out which regions have inscribed geometries
-        vc_results = findRegionsWithInscribed(inscribed[0].vcopts, base_geom, inscribed_geoms, transforms);
+        vc_results = findRegionsWithInscribed(vcopts, base_geom, inscribed_geoms, transforms);
     }
 
 
@@ -160,6 +178,23 @@ EGS_AEnvelope::EGS_AEnvelope(EGS_BaseGeometry *base_geom,
         writeVolumeCorrection();
     }
 
+    if (cache_file != "") {
+        // Other jobs of a parallel run may be reading the cache file, so it
+        // is written under a temporary name and renamed once complete
+        EGS_Application *app = EGS_Application::activeApplication();
+        ostringstream tmp;
+        tmp << cache_file << ".tmp" << (app ? app->getIparallel() : 0);
+        egsInformation("Writing volume correction cache file %s\n", cache_file.c_str());
+        ofstream out(tmp.str().c_str());
+        writeVCToFile(out);
+        out.close();
+        if (!out.good() || rename(tmp.str().c_str(), cache_file.c_str())) {
+            egsWarning("EGS_AEnvelope: failed to write volume correction "
+                       "cache file %s\n", cache_file.c_str());
+            remove(tmp.str().c_str());
+        }
+    }
+
     if (debug_info) {
         printInfo();
     }
@@ -706,13 +741,15 @@ void EGS_AEnvelope::writeVCToFile(ostream &out) {
         EGS_Float cor =  vc_results.corrected_volumes[i];
         EGS_Float uncor =  vc_results.uncorrected_volumes[i];
         bool has_correction = fabs(cor-uncor) > 1E-8;
-        if (has_correction) {
+        // also write regions found in discovery only mode
+        if (has_correction || getGeomsInRegion(i).size() > 0) {
             to_write.push_back(i);
         }
     }
 
     size_t nrecords = to_write.size();
     out << nrecords << endl;
+    out.precision(12);
 
     for (size_t i=0; i<to_write.size(); i++) {
         int ir = to_write[i];
@@ -249,6 +249,12 @@ There is an example geometry included in the examples/seeds_in_xyz_aenv.geom fil
 
             # -or-
 
+            :start rng definition:
+                type = halton # quasi-random points, box shapes only
+            :stop rng definition:
+
+            # -or-
+
             :start rng definition:
                 type = ranmar
                 initial seeds = 123, 456
@@ -288,6 +294,32 @@ volume correction block like the following for the inscribed geometry:
 This allows you to e.g. run a lengthy volume correction a single time and
 then reuse the volume correction file in future runs.
 
+Alternatively, adding
+
+\verbatim
+
+   :start region discovery:
+       ...
+       cache volume corrections = yes # optional: no(default), yes
+   :stop region discovery:
+
+\endverbatim
+
+makes the geometry manage such a file automatically. The file is named
+`base_geometry_name.autoenv.HASH.volcor`, where `HASH` is computed from the
+region discovery options, the base geometry regions and volumes, the
+locations of the inscribed geometries and the response of the geometries
+to a fixed set of test points. If the file exists, the volume corrections
+are loaded from it, otherwise they are computed and the file is written.
+Parallel jobs with the same input therefore only repeat the volume
+correction until the first job has finished it. The file is written under
+a temporary name and renamed when complete, so a job never reads a partially
+written file. Changing the options, the base geometry regions and volumes or
+the placement of the inscribed geometries results in a new hash. Other
+changes to a geometry are only detected if they change its response at the
+test points, so delete the cache files after editing the geometries
+themselves.
+
 Points to consider
 ------------------
 
@@ -302,7 +334,11 @@ insribed geometry or you choose a density of points that is too low.
 By default a Sobol quasi-random number generator (if available, see
     `Optional Features` below) is used for volume correction/region
 discovery but that can be overridden by including an `rng definition`
-block (see example input above)
+block (see example input above). A built-in Halton quasi-random sequence,
+which does not require the optional features, can be selected for box
+bounding shapes with `type = halton`. Like the Sobol sequence, it
+covers the bounding box much more evenly than pseudo-random points, so
+a lower density of points gives the same accuracy.
 
 
 EGS_ASwitchedEnvelope
@@ -51,6 +51,7 @@
 #include <map>
 #include <set>
 #include <cstdlib>
+#include <cstdio>
 #include <fstream>
 
 #include "egs_base_geometry.h"
@@ -78,6 +79,107 @@
 namespace volcor {
 
 
+/*! \brief A Halton quasi-random sequence for points in a box
+ *
+ * Consecutive calls to getUniform() return the x, y and z coordinates of
+ * the points of the 3D Halton sequence with bases 2, 3 and 5. Since the
+ * points fill the unit cube much more evenly than pseudo-random points, the
+ * volume estimates converge faster. As with the Sobol generator, this is
+ * only meaningful for box bounding shapes, which consume exactly three
+ * numbers per point. Unlike Sobol, no external code is required.
+ */
+class VCHalton : public EGS_RandomGenerator {
+
+public:
+
+    VCHalton(EGS_I64 first=1) : EGS_RandomGenerator(), index(first),
+        dim(0), copy(0) {};
+
+    ~VCHalton() {
+        if (copy) {
+            delete copy;
+        }
+    };
+
+    void fillArray(int n, EGS_Float *array) {
+        static const int bases[] = {2, 3, 5};
+        for (int i=0; i<n; i++) {
+            array[i] = radicalInverse(index,bases[dim]);
+            if (++dim == 3) {
+                dim = 0;
+                ++index;
+            }
+        }
+        count += n;
+    };
+
+    void describeRNG() const {
+        egsInformation("Random number generator:\n"
+                       "============================================\n");
+        egsInformation("  type                = Halton (bases 2,3,5)\n");
+        egsInformation("  next point          = %lld\n",index);
+    };
+
+    EGS_RandomGenerator *getCopy() {
+        VCHalton *c = new VCHalton(index);
+        c->setState(this);
+        return c;
+    };
+
+    void setState(EGS_RandomGenerator *r) {
+        VCHalton *h = dynamic_cast<VCHalton *>(r);
+        if (!h) {
+            egsFatal("VCHalton::setState: not a VCHalton generator\n");
+        }
+        copyBaseState(*r);
+        index = h->index;
+        dim = h->dim;
+    };
+
+    void saveState() {
+        if (!copy) {
+            copy = new VCHalton();
+        }
+        copy->setState(this);
+    };
+
+    void resetState() {
+        if (copy) {
+            setState(copy);
+        }
+    };
+
+    int rngSize() const {
+        return baseSize() + sizeof(EGS_I64) + sizeof(int);
+    };
+
+protected:
+
+    bool storePrivateState(ostream &data) {
+        data << index << "  " << dim << endl;
+        return data.good();
+    };
+
+    bool setPrivateState(istream &data) {
+        data >> index >> dim;
+        return data.good();
+    };
+
+    static EGS_Float radicalInverse(EGS_I64 i, int base) {
+        EGS_Float f = 1./base, r = 0;
+        while (i > 0) {
+            r += f*(i%base);
+            i /= base;
+            f /= base;
+        }
+        return r;
+    };
+
+    EGS_I64  index; //!< index of the current point in the sequence
+    int      dim;   //!< coordinate of the current point returned next
+    VCHalton *copy; //!< saved state
+};
+
 /*! Available volume correction modes */
 enum VolCorMode {
     DISCOVERY_ONLY,  /*!< Region discovery only. No volume correction applied */
@@ -247,7 +349,8 @@ public:
 
     /*! VCOptions constructor. Initializes volume correction options from given input */
     VCOptions(EGS_Input *inp):
-        rng(NULL), vc_file(""), input(inp), bounds(NULL), sobolAllowed(false) {
+        rng(NULL), vc_file(""), use_cache(false), input(inp), bounds(NULL),
+        sobolAllowed(false) {
 
         valid=true;
 
@@ -261,6 +364,8 @@ public:
         // set external file to load volume corrections from
         setVCFile();
 
+        setCache();
+
         if (vc_file == "") {
             // no external file found. Run a MC volume correction
 
@@ -291,6 +396,11 @@ public:
         return bounds->getRandomPoint(rng);
     }
 
+    /*! Return a random point within the boundary shape using \a r. */
+    EGS_Vector getRandomPoint(EGS_RandomGenerator *r) {
+        return bounds->getRandomPoint(r);
+    }
+
     bool valid; /*!< was the object initialized completely? */
 
     double bounds_volume; /*!< Volume of bounding shape in cm^3 */
@@ -302,6 +412,7 @@ public:
 
     EGS_RandomGenerator *rng;
     string vc_file;
+    bool use_cache; /*!< store/reuse results in a file named after the inputs */
 
 protected:
 
@@ -330,6 +441,14 @@ protected:
         }
     }
 
+    /*! should results be cached in a file keyed by a hash of the inputs? */
+    void setCache() {
+        vector<string> choices;
+        choices.push_back("no");
+        choices.push_back("yes");
+        use_cache = input->getInput("cache volume corrections", choices, 0);
+    }
+
     /*! create bounding shape from the shape input and calculate its volume */
     int setBoundsShape() {
 
@@ -380,7 +499,19 @@ protected:
         if (rng_input) {
             string type;
             int err = rng_input->getInput("type", type);
-            if (!err && rng_input->compare(type, "sobol")) {
+            if (!err && rng_input->compare(type, "halton")) {
+                if (!sobolAllowed) {
+                    egsWarning(
+                        "Halton QRNG are not allowed for non rectilinear shapes. "
+                        "Using default Ranmar instead.\n"
+                    );
+                    rng = EGS_RandomGenerator::defaultRNG();
+                }
+                else {
+                    rng = new VCHalton();
+                }
+            }
+            else if (!err && rng_input->compare(type, "sobol")) {
                 if (!sobolAllowed) {
                     egsWarning(
                         "Sobol QRNG are not allowed for non rectilinear shapes. "
@@ -621,6 +752,88 @@ VCResults findRegionsWithInscribed(VCOptions *opts, EGS_BaseGeometry *base,
 }
 
 
+/*! \brief Hash identifying the result of a region discovery run
+ *
+ * The hash combines the volume correction options, the type, number of
+ * regions and volumes of the base geometry, the inscribed geometry
+ * locations and, as a fingerprint of the geometry definitions, the outcome
+ * of isInside/isWhere for a fixed set of points in the bounding shape.
+ * It is used to name cached volume correction files so that a cache file
+ * is only reused for an unchanged geometry.
+ */
+string getVCHash(VCOptions *opts, EGS_BaseGeometry *base,
+                 vector<EGS_BaseGeometry *> inscribed, vector<EGS_AffineTransform *> transforms) {
+
+    // 64 bit FNV-1a
+    unsigned long long h = 14695981039346656037ULL;
+    struct Hasher {
+        unsigned long long &h;
+        Hasher(unsigned long long &H) : h(H) {};
+        void add(const void *data, size_t n) {
+            const unsigned char *c = (const unsigned char *)data;
+            for (size_t i=0; i<n; i++) {
+                h = (h ^ c[i])*1099511628211ULL;
+            }
+        };
+        void add(const string &s) {
+            add(s.c_str(), s.size());
+        };
+        void add(double x) {
+            add(&x, sizeof(x));
+        };
+        void add(int i) {
+            add(&i, sizeof(i));
+        };
+        void add(const EGS_Vector &v) {
+            add(v.x);
+            add(v.y);
+            add(v.z);
+        };
+    } hasher(h);
+
+    hasher.add((int)opts->mode);
+    hasher.add((double)opts->density);
+    hasher.add(opts->bounds_volume);
+
+    hasher.add(base->getType());
+    hasher.add(base->regions());
+    for (int ir=0; ir < base->regions(); ir++) {
+        hasher.add((double)base->getVolume(ir));
+    }
+
+    hasher.add((int)inscribed.size());
+    for (size_t i=0; i < transforms.size(); i++) {
+        hasher.add(inscribed[i]->getType());
+        hasher.add(inscribed[i]->regions());
+        EGS_Vector o(0,0,0), ex(1,0,0), ey(0,1,0);
+        transforms[i]->transform(o);
+        transforms[i]->transform(ex);
+        transforms[i]->transform(ey);
+        hasher.add(o);
+        hasher.add(ex);
+        hasher.add(ey);
+    }
+
+    EGS_RandomGenerator *probe_rng = EGS_RandomGenerator::defaultRNG(97);
+    for (int i=0; i < 1000; i++) {
+        EGS_Vector point = opts->getRandomPoint(probe_rng);
+        EGS_Vector inscribed_point(point);
+        transforms[0]->transform(inscribed_point);
+        hasher.add(inscribed[0]->isWhere(inscribed_point));
+        for (size_t sidx = 0; sidx < transforms.size();  sidx++) {
+            EGS_Vector transformed(point);
+            transforms[sidx]->transform(transformed);
+            hasher.add(base->isWhere(transformed));
+        }
+    }
+    delete probe_rng;
+
+    char buf[32];
+    sprintf(buf, "%016llx", h);
+    return string(buf);
+}
+
+
 bool isGZip(istream &vfile) {
     return (vfile.get() == 0x1f && vfile.get() == 0x8b);
 }
@@ -39,6 +39,7 @@
 
 #include "egs_base_geometry.h"
 #include "egs_transformations.h"
+#include "egs_bounding_box.h"
 
 
 #ifdef WIN32
@@ -414,6 +415,15 @@ public:
         return sqrt(s2);
     };
 
+    bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+        xmin = EGS_Vector(-0.5*ax,-0.5*ay,-0.5*az);
+        xmax = EGS_Vector(0.5*ax,0.5*ay,0.5*az);
+        if (T) {
+            EGS_BoundingBoxTree::transformBox(*T,xmin,xmax);
+        }
+        return true;
+    };
+
     const string &getType() const {
         return type;
     };
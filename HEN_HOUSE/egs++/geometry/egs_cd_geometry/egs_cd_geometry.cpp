@@ -108,6 +108,60 @@ void EGS_CDGeometry::setUpIndexing() {
     nreg = nr;
 }
 
+bool EGS_CDGeometry::getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+    bool has_box = bg->getBoundingBox(xmin,xmax);
+    EGS_Vector umin(veryFar,veryFar,veryFar), umax(-veryFar,-veryFar,-veryFar);
+    for (int j=0; j<nbase; j++) {
+        EGS_Vector amin, amax;
+        if (!g[j] || !g[j]->getBoundingBox(amin,amax)) {
+            return has_box;
+        }
+        EGS_BoundingBoxTree::mergeBox(amin,amax,umin,umax);
+    }
+    if (has_box) {
+        EGS_BoundingBoxTree::intersectBox(xmin,xmax,umin,umax);
+    }
+    xmin = umin;
+    xmax = umax;
+    return nbase > 0;
+}
+
+int EGS_CDGeometry::buildBoundingBoxTree() {
+    if (bbox_tree) {
+        delete bbox_tree;
+        bbox_tree = 0;
+    }
+    EGS_Float tol = boundaryTolerance;
+    for (int j=0; j<nbase; j++) {
+        if (g[j] && g[j]->getBoundaryTolerance() > tol) {
+            tol = g[j]->getBoundaryTolerance();
+        }
+    }
+    EGS_BoundingBoxTree *tree = new EGS_BoundingBoxTree;
+    tree->build(nbase,g,tol);
+    int nbox = tree->nBounded();
+    if (!nbox) {
+        delete tree;
+        return 0;
+    }
+    bbox_tree = tree;
+    return nbox;
+}
+
+void EGS_CDGeometry::setBoundingBoxTree(EGS_Input *input) {
+    if (!input) {
+        return;
+    }
+    vector<string> options;
+    options.push_back("no");
+    options.push_back("yes");
+    int use_tree = input->getInput("bounding box tree",options,0);
+    if (use_tree && !buildBoundingBoxTree()) {
+        egsWarning("EGS_CDGeometry::setBoundingBoxTree: none of the inscribed"
+                   " geometries of %s has a bounding box\n",name.c_str());
+    }
+}
+
 
 extern "C" {
 
@@ -249,11 +303,12 @@ extern "C" {
         g->ref();
         int indexing = 0;
         input->getInput("new indexing style",indexing);
-        EGS_BaseGeometry *result = new EGS_CDGeometry(g,G,"",indexing);
+        EGS_CDGeometry *result = new EGS_CDGeometry(g,G,"",indexing);
         delete [] G;
         result->setName(input);
         result->setBoundaryTolerance(input);
         result->setLabels(input);
+        result->setBoundingBoxTree(input);
         return result;
 
     }
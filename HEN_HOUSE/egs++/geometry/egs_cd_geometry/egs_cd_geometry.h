@@ -43,6 +43,7 @@
 
 #include "egs_base_geometry.h"
 #include "egs_functions.h"
+#include "egs_bounding_box.h"
 
 #ifdef WIN32
 
@@ -201,6 +202,20 @@ set geometry = start region, stop region, name of a previously defined geometry
 \endverbatim
 There can be an arbitrary number of <code> set geometry</code> keys.
 
+When a particle outside of the inscribed geometries moves through the base
+geometry, the inscribed geometry of each base region it crosses is asked
+whether the particle enters it. With
+\verbatim
+bounding box tree = yes
+\endverbatim
+the bounding boxes of the inscribed geometries are computed at
+initialization (see EGS_BaseGeometry::getBoundingBox()) and these checks
+are skipped when the step does not cross the box of the inscribed geometry.
+This is useful when the inscribed geometries are expensive to query
+(\em e.g. envelopes or unions with many parts) and only occupy a small
+part of their base region. hownear() may then return larger, but still
+safe, distances than without the boxes.
+
 As concluding remark for the CD geometry type, it is worth noting
 that the treatment head of a medical linear accelerator can be
 efficiently modeled with the help of a CD geometry. This can
@@ -273,6 +288,7 @@ public:
         new_indexing = false;
         reg_to_base = 0;
         local_start = 0;
+        bbox_tree = 0;
         nbase = G1->regions();
         g = new EGS_BaseGeometry* [nbase];
         bg = G1; //bg->ref();
@@ -306,6 +322,7 @@ public:
         new_indexing = false;
         reg_to_base = 0;
         local_start = 0;
+        bbox_tree = 0;
         if (nbase != G.size()) egsFatal("EGS_CDGeometry: number of passed"
                                             " geometries (%d) is not the same as the number of regions (%d)\n",
                                             nbase,G.size());
@@ -347,6 +364,9 @@ public:
         if (!bg->deref()) {
             delete bg;
         }
+        if (bbox_tree) {
+            delete bbox_tree;
+        }
         if (new_indexing) {
             if (reg_to_base) {
                 delete [] reg_to_base;
@@ -472,7 +492,7 @@ public:
                     // there is a geometry in this new base geometry region.
                     // are we already inside?
                     EGS_Vector tmp(x + u*t);
-                    int icd_new = g[ibase_new]->isWhere(tmp);
+                    int icd_new = inscribedIsWhere(ibase_new,tmp);
                     if (icd_new < 0) {
                         return icd_new;
                     }
@@ -522,7 +542,7 @@ public:
             // outside. To make the logic below work, we need to
             // check if we are inside the geometry inscribed in region
             // ibase.
-            int icd = g[ibase] ? g[ibase]->isWhere(x) : 0;
+            int icd = g[ibase] ? inscribedIsWhere(ibase,x) : 0;
             if (icd >= 0) {
 
                 // We think we are outside, but isWhere(x) reports that we are
@@ -647,7 +667,7 @@ public:
                 if (t1 < boundaryTolerance && ibase_n >= 0 && g[ibase_n]) {
                     // last resort.
                     EGS_Vector xtmp(x + u*t1);
-                    int icdx = g[ibase_n]->isWhere(xtmp);
+                    int icdx = inscribedIsWhere(ibase_n,xtmp);
                     if (icdx < 0) {
                         tb = t1;
                         ttot = tb;
@@ -708,7 +728,7 @@ do_checks:
             // => we have entered.
             int icd = -1;
             if (!first_time) { // already howfar-checked base geometry
-                icd = g[ibase]->isWhere(tmp);
+                icd = inscribedIsWhere(ibase,tmp);
                 if (icd >= 0) {
                     // already inside of the geometry of this base geometry
                     // region.
@@ -729,8 +749,11 @@ do_checks:
             EGS_Float tnew = t - ttot;
             int ibase_new = bg->howfar(ibase,tmp,u,tnew,pmednew,pn);
             // see if we will enter the cd geometry of this base geometry
-            // region.
-            int icd_new = g[ibase]->howfar(-1,tmp,u,tnew,pmednew,pn);
+            // region (not possible if the step misses its bounding box).
+            int icd_new = -1;
+            if (!bbox_tree || bbox_tree->mayHit(ibase,tmp,u,tnew)) {
+                icd_new = g[ibase]->howfar(-1,tmp,u,tnew,pmednew,pn);
+            }
             if (icd_new >= 0) {
                 // yes, we will.
                 t = ttot + tnew;
@@ -799,7 +822,7 @@ do_checks:
             return tt;
         }
         EGS_Float t = bg->hownear(ibase,x);
-        if (g[ibase]) {
+        if (g[ibase] && (!bbox_tree || bbox_tree->distance(ibase,x) < t)) {
             EGS_Float t1 = g[ibase]->hownear(-1,x);
             if (t1 < t) {
                 t = t1;
@@ -869,6 +892,26 @@ do_checks:
         setPropertError("addBooleanProperty()");
     };
 
+    /*! \brief The box of the base geometry
+
+     If every base region has an inscribed geometry with a bounding box,
+     the box is narrowed to the union of the inscribed boxes.
+    */
+    bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax);
+
+    /*! \brief Reads the bounding box option from \a input
+
+     Computes the bounding boxes of the inscribed geometries if the input
+     contains <code>bounding box tree = yes</code>.
+    */
+    void setBoundingBoxTree(EGS_Input *input);
+
+    /*! \brief Computes the bounding boxes of the inscribed geometries
+
+     Returns the number of inscribed geometries with a bounding box.
+    */
+    int buildBoundingBoxTree();
+
     const string &getType() const {
         return type;
     };
@@ -925,6 +968,18 @@ protected:
         region in base region ibase */
     int              *local_start;
 
+    /*! Bounding boxes of the inscribed geometries, if used */
+    EGS_BoundingBoxTree *bbox_tree;
+
+    /*! Region of \a x in the geometry inscribed in base region \a ibase,
+        skipping the query if \a x is outside of its bounding box */
+    int inscribedIsWhere(int ibase, const EGS_Vector &x) {
+        if (bbox_tree && !bbox_tree->mayContain(ibase,x)) {
+            return -1;
+        }
+        return g[ibase]->isWhere(x);
+    };
+
     void setMedia(EGS_Input *inp, int, const int *);
 
 private:
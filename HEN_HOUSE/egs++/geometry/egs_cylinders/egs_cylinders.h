@@ -479,6 +479,24 @@ public:
         return 2*nreg + 1;
     };
 
+    /*! \brief A box around the outer cylinder
+
+      The cylinders are infinitely long, so the box is only bounded in the
+      directions perpendicular to the axis.
+     */
+    bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+        if (nreg < 1) {
+            return false;
+        }
+        EGS_Vector n = a.normal();
+        EGS_Float r = R[nreg-1];
+        xmin = EGS_Vector(n.x ? -veryFar : xo.x-r, n.y ? -veryFar : xo.y-r,
+                          n.z ? -veryFar : xo.z-r);
+        xmax = EGS_Vector(n.x ? veryFar : xo.x+r, n.y ? veryFar : xo.y+r,
+                          n.z ? veryFar : xo.z+r);
+        return true;
+    };
+
     const string &getType() const {
         return a.getType();
     };
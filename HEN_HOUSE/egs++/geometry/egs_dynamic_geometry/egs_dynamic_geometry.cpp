@@ -37,6 +37,10 @@
 #include "egs_dynamic_geometry.h"
 #include "egs_input.h"
 #include "egs_functions.h"
+#include <algorithm>
+
+// Maximum number of sampled time indices rejected in a row before giving up
+static const int max_time_tries = 100000;
 
 // ----------------------------------------------------------------------------
 // Implementation of EGS_DynamicGeometry methods
@@ -227,77 +231,98 @@ extern "C" {
             }
         }
 
+        buildSegments();
+
         // Sets position to initial time in egs_view upon opening
         updatePosition(0);
     }
 
-    int EGS_DynamicGeometry::getCoordGeom(EGS_Float rand, EGS_ControlPoint &gipt) {
-        int iindex = 0;
-        int i;
-
-        // The following loop determines which 2 control points the current time
-        // index falls between
-        for (i = 0; i < ncpts; i++) {
-            if (rand < cpts[i].time - epsilon) {
-                iindex = i;
-                break;
+    void EGS_DynamicGeometry::buildSegments() {
+        // The time index search and the differences between consecutive
+        // control points are done once here instead of for every history
+        nrot = cpts[0].rot.size();
+        cur_seg = -1;
+        tsearch.resize(ncpts);
+        segments.resize(ncpts - 1);
+        for (int i = 0; i < ncpts; i++) {
+            tsearch[i] = cpts[i].time - epsilon;
+        }
+        for (int i = 0; i < ncpts - 1; i++) {
+            EGS_MotionSegment &s = segments[i];
+            s.t0 = cpts[i].time;
+            s.dt = cpts[i + 1].time - cpts[i].time;
+            for (int j = 0; j < 3; j++) {
+                s.trnsl[j] = cpts[i].trnsl[j];
+                s.dtrnsl[j] = cpts[i + 1].trnsl[j] - cpts[i].trnsl[j];
+                s.rot[j] = j < nrot ? cpts[i].rot[j] : 0;
+                s.drot[j] = j < nrot ? cpts[i + 1].rot[j] - cpts[i].rot[j] : 0;
+            }
+            // Segments without rotation (e.g. step and shoot or pure
+            // translation) get their rotation matrix precomputed
+            s.fixed_rot = s.drot[0] == 0 && s.drot[1] == 0 && s.drot[2] == 0;
+            s.fixed = s.fixed_rot && s.dtrnsl[0] == 0 && s.dtrnsl[1] == 0 && s.dtrnsl[2] == 0;
+            if (s.fixed_rot) {
+                s.R = nrot == 2 ?
+                      EGS_RotationMatrix(s.rot[0] * (M_PI / 180), s.rot[1] * (M_PI / 180)) :
+                      EGS_RotationMatrix(s.rot[0] * (M_PI / 180), s.rot[1] * (M_PI / 180), s.rot[2] * (M_PI / 180));
             }
         }
+    }
 
-        if (i == ncpts) {
+    int EGS_DynamicGeometry::getCoordGeom(EGS_Float rand, EGS_AffineTransform &t, int *iseg) const {
+
+        // Find the first control point with a time index larger than rand,
+        // i.e. the upper bound of the segment the current time index falls in
+        int iindex = upper_bound(tsearch.begin(), tsearch.end(), rand) - tsearch.begin();
+
+        if (iindex == 0 || iindex == ncpts) {
             egsWarning("EGS_DynamicGeometry: could not locate control point.\n");
             return 1;
         }
+        const EGS_MotionSegment &s = segments[iindex - 1];
+        if (iseg) {
+            *iseg = iindex - 1;
+        }
 
-        // Below 3 vectors are defined, a vector containing the lower bound
-        // translation coordinates, a vector containing the upper bound
-        // translation coordinates, and a vector for the sampled translation
-        // coordinates
-        vector<EGS_Float> translation_LB = cpts[iindex - 1].trnsl;
-        vector<EGS_Float> translation_UB = cpts[iindex].trnsl;
-        vector<EGS_Float> translation_samp;
-
-        // The following is a factor (between 0 and 1) used for sampling.
-        // Essentially, it represents the fractional position within the
-        // interval
-        EGS_Float factor = (rand - cpts[iindex - 1].time) / (cpts[iindex].time - cpts[iindex - 1].time);
-
-        // Translations are given as the lower bound plus the length of the
-        // interval multiplied by the fractional position factor. So its
-        // essentially lower bound + n% of the interval length
-        translation_samp.push_back(translation_LB[0] + (translation_UB[0] - translation_LB[0]) * factor);
-        translation_samp.push_back(translation_LB[1] + (translation_UB[1] - translation_LB[1]) * factor);
-        translation_samp.push_back(translation_LB[2] + (translation_UB[2] - translation_LB[2]) * factor);
-
-        // Update the translation coordinates in the current state control point object
-        gipt.trnsl = translation_samp;
-
-        // Again 3 vectors defined, lower bound, upper bound, and sampled, this
-        // time for rotation coordinates
-        vector<EGS_Float> rotation_LB = cpts[iindex - 1].rot;
-        vector<EGS_Float> rotation_UB = cpts[iindex].rot;
-        vector<EGS_Float> rotation_samp;
-
-        // Now set rotations. Current coordinates computed as before
-        // (lowerbound+n% of interval length), but now we also convert degrees
-        // to radians These must be done case by case (since order of arguments
-        // matters)
-        if (cpts[iindex].rot.size() == 2) {
-            rotation_samp.push_back((rotation_LB[0] + (rotation_UB[0] - rotation_LB[0]) * factor) * (M_PI / 180));
-            rotation_samp.push_back((rotation_LB[1] + (rotation_UB[1] - rotation_LB[1]) * factor) * (M_PI / 180));
+        // The fractional position within the interval. Translations and
+        // rotations are the lower bound plus this fraction of the change
+        // over the interval
+        EGS_Float factor = (rand - s.t0) / s.dt;
+        EGS_Vector trnsl(s.trnsl[0] + s.dtrnsl[0] * factor,
+                         s.trnsl[1] + s.dtrnsl[1] * factor,
+                         s.trnsl[2] + s.dtrnsl[2] * factor);
+        if (s.fixed_rot) {
+            t = EGS_AffineTransform(s.R, trnsl);
         }
-        else if (cpts[iindex].rot.size() == 3) {
-            rotation_samp.push_back((rotation_LB[0] + (rotation_UB[0] - rotation_LB[0]) * factor) * (M_PI / 180));
-            rotation_samp.push_back((rotation_LB[1] + (rotation_UB[1] - rotation_LB[1]) * factor) * (M_PI / 180));
-            rotation_samp.push_back((rotation_LB[2] + (rotation_UB[2] - rotation_LB[2]) * factor) * (M_PI / 180));
+        else if (nrot == 2) {
+            t = EGS_AffineTransform(EGS_RotationMatrix(
+                                        (s.rot[0] + s.drot[0] * factor) * (M_PI / 180),
+                                        (s.rot[1] + s.drot[1] * factor) * (M_PI / 180)), trnsl);
         }
         else {
-            egsWarning("EGS_DynamicGeometry: Invalid number of rotation parameters\n");
+            t = EGS_AffineTransform(EGS_RotationMatrix(
+                                        (s.rot[0] + s.drot[0] * factor) * (M_PI / 180),
+                                        (s.rot[1] + s.drot[1] * factor) * (M_PI / 180),
+                                        (s.rot[2] + s.drot[2] * factor) * (M_PI / 180)), trnsl);
         }
 
-        // Update the rotation coordinates in the current state control point object
-        gipt.rot = rotation_samp;
+        return 0;
+    }
+
+    int EGS_DynamicGeometry::moveTo(EGS_Float time) {
 
+        // Within a segment without motion the transformation is kept. With
+        // time sorted histories (see EGS_Application::getNextTimeIndex())
+        // this is the case for most histories of e.g. step and shoot
+        // sequences. Time index t is in segment i if tsearch[i] <= t < tsearch[i+1]
+        if (cur_seg >= 0 && time >= tsearch[cur_seg] && time < tsearch[cur_seg + 1]) {
+            return 0;
+        }
+        int iseg;
+        if (getCoordGeom(time, T, &iseg)) {
+            return 1;
+        }
+        cur_seg = segments[iseg].fixed ? iseg : -1;
         return 0;
     }
 
@@ -394,13 +419,14 @@ extern "C" {
 
     void EGS_DynamicGeometry::getNextGeom(EGS_RandomGenerator *rndm) {
         int errg = 1;
-        EGS_ControlPoint gipt;
+        int ntry = 0;
 
         // Get the source from active application to extract time
         EGS_Application *app = EGS_Application::activeApplication();
         while (errg) {
             // Get time from source if it exists (otherwise gives -1)
             ptime = app->getTimeIndex();
+            bool sampled = ptime < 0 || app->isTimeIndexPreset();
             if (ptime < 0) {
                 // If no time is given by the source, randomly sample from 0 to 1
                 ptime = rndm->getUniform();
@@ -408,35 +434,37 @@ extern "C" {
                 // simulation (through base source)
                 app->setTimeIndex(ptime);
             }
-            // Run the `getCoordGeom` method that will sample the control points
-            // given to find the transformation that will be applied for the
-            // current history
-            errg = getCoordGeom(ptime, gipt);
+            // Run the `moveTo` method that will interpolate the control points
+            // to find the transformation that will be applied for the current
+            // history
+            errg = moveTo(ptime);
+            if (errg) {
+                // A time index from the source would be the same on every
+                // try. A sampled one is rejected and sampled again (e.g. if
+                // the first control point has a time index > 0)
+                if (!sampled) {
+                    egsFatal("EGS_DynamicGeometry: the time index %g from the "
+                             "source is outside of the control points\n", ptime);
+                }
+                if (++ntry >= max_time_tries) {
+                    egsFatal("EGS_DynamicGeometry: no time index within the "
+                             "control points after %d attempts\n", ntry);
+                }
+                app->setTimeIndex(-1);
+            }
         }
 
-        // Create and set the current geometry transformation using the sampled
-        // coordinates from `getCoordGeom`. This is where the overloaded
-        // `EGS_AffineTransform` is used
-        EGS_AffineTransform *tDG = EGS_AffineTransform::getTransformation(gipt.trnsl, gipt.rot);
-        setTransformation(*tDG);
-
         // Call `getNextGeom` on base geometry in case there are lower-level
         // dynamic geometries
         g->getNextGeom(rndm);
     }
 
     void EGS_DynamicGeometry::updatePosition(EGS_Float time) {
-        int errg = 1;
-        EGS_ControlPoint gipt;
-
-        // Run the `getCoordGeom` method that will use the control points given
-        // to find the transformation that will be applied for the current time
-        // index
-        errg = getCoordGeom(time, gipt);
 
-        // Create and set the geometry transform with the updated coordinates
-        EGS_AffineTransform *tDG = EGS_AffineTransform::getTransformation(gipt.trnsl, gipt.rot);
-        setTransformation(*tDG);
+        // Run the `moveTo` method that will use the control points given to
+        // find and set the transformation for the current time index. The
+        // transformation is left unchanged if the time index is out of range
+        moveTo(time);
 
         // Call `updatePosition` on the base to allow lower-level geometries to
         // update as needed
@@ -174,6 +174,7 @@ public:
      */
     void setTransformation(EGS_AffineTransform t) {
         T = t;
+        cur_seg = -1;
     };
 
     /*!
@@ -400,6 +401,27 @@ protected:
     int ncpts;             //!< Number of control points
     EGS_Float ptime;       //!< Time index corresponding to the particle
 
+    /*!
+     * \struct EGS_MotionSegment
+     * \brief Interpolation data for the motion between two consecutive control points.
+     */
+    struct EGS_MotionSegment {
+        EGS_Float t0;          //!< Time index at the start of the segment
+        EGS_Float dt;          //!< Length of the segment in time index
+        EGS_Float trnsl[3];    //!< Translation at the start of the segment
+        EGS_Float dtrnsl[3];   //!< Change of the translation over the segment
+        EGS_Float rot[3];      //!< Rotation angles (degrees) at the start of the segment
+        EGS_Float drot[3];     //!< Change of the rotation angles over the segment
+        bool fixed_rot;        //!< True if the rotation is constant over the segment
+        bool fixed;            //!< True if the geometry does not move over the segment
+        EGS_RotationMatrix R;  //!< The rotation if \a fixed_rot is true
+    };
+
+    vector<EGS_Float> tsearch;          //!< Control point time indices minus epsilon, searched for the segment
+    vector<EGS_MotionSegment> segments; //!< Segment i interpolates between control points i and i+1
+    int nrot;              //!< Number of rotation parameters (2 or 3)
+    int cur_seg;           //!< The segment of the current position if it has no motion, -1 otherwise
+
     /*!
      * \brief Don't define media in the transformed geometry definition.
      *
@@ -410,13 +432,33 @@ protected:
     void setMedia(EGS_Input *inp, int, const int *);
 
     /*!
-     * \brief Extract coordinates for the next dynamic geometry position.
+     * \brief Get the transformation of the dynamic geometry at time index \a rand.
+     *
+     * The segment containing \a rand is found by a binary search in the
+     * segment table built by buildSegments().
      *
      * \param rand Random number for time sampling.
-     * \param gipt EGS_ControlPoint structure to store the coordinates.
+     * \param t The interpolated transformation.
+     * \param iseg If not null, set to the index of the segment.
      * \return 0 if successful, otherwise 1.
      */
-    int getCoordGeom(EGS_Float rand, EGS_ControlPoint &gipt);
+    int getCoordGeom(EGS_Float rand, EGS_AffineTransform &t, int *iseg = 0) const;
+
+    /*!
+     * \brief Moves the geometry to its position at time index \a time.
+     *
+     * The transformation is only recomputed if \a time is not in the same
+     * segment without motion as the current position.
+     *
+     * \param time Time index.
+     * \return 0 if successful, otherwise 1 (the position is then unchanged).
+     */
+    int moveTo(EGS_Float time);
+
+    /*!
+     * \brief Build the segment table from the (normalized) control points.
+     */
+    void buildSegments();
 
     /*!
      * \brief Builds the dynamic geometry using input specifications.
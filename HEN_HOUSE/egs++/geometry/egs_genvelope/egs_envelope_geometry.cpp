@@ -112,7 +112,8 @@ struct EGS_ENVELOPEG_LOCAL EnvelopeAux {
 EGS_EnvelopeGeometry::EGS_EnvelopeGeometry(EGS_BaseGeometry *G,
         const vector<EGS_BaseGeometry *> &geoms, const string &Name,
         bool newindexing) :
-    EGS_BaseGeometry(Name), reg_to_inscr(0), local_start(0) {
+    EGS_BaseGeometry(Name), reg_to_inscr(0), local_start(0), bbox_tree(0),
+    bbox_list(0) {
     if (!G) {
         egsFatal("EGS_EnvelopeGeometry: base geometry must not be null\n");
     }
@@ -273,6 +274,10 @@ EGS_FastEnvelope::EGS_FastEnvelope(EGS_BaseGeometry *G,
 }
 
 EGS_EnvelopeGeometry::~EGS_EnvelopeGeometry() {
+    if (bbox_tree) {
+        delete bbox_tree;
+        delete [] bbox_list;
+    }
     if (!g->deref()) {
         delete g;
     }
@@ -314,6 +319,53 @@ EGS_FastEnvelope::~EGS_FastEnvelope() {
     }
 }
 
+int EGS_EnvelopeGeometry::buildBoundingBoxTree() {
+    if (bbox_tree) {
+        delete bbox_tree;
+        delete [] bbox_list;
+        bbox_tree = 0;
+        bbox_list = 0;
+    }
+    if (n_in < 1) {
+        return 0;
+    }
+    EGS_Float tol = boundaryTolerance;
+    for (int j=0; j<n_in; j++) {
+        EGS_Float tj = geometries[j]->getBoundaryTolerance();
+        if (tj > tol) {
+            tol = tj;
+        }
+    }
+    EGS_BoundingBoxTree *tree = new EGS_BoundingBoxTree;
+    tree->build(n_in,geometries,tol);
+    int nbox = tree->nBounded();
+    if (!nbox) {
+        delete tree;
+        return 0;
+    }
+    bbox_tree = tree;
+    bbox_list = new int [n_in];
+    return nbox;
+}
+
+void EGS_EnvelopeGeometry::setBoundingBoxTree(EGS_Input *input) {
+    if (!input) {
+        return;
+    }
+    vector<string> options;
+    options.push_back("no");
+    options.push_back("yes");
+    int use_tree = input->getInput("bounding box tree",options,0);
+    if (!use_tree) {
+        return;
+    }
+    if (!buildBoundingBoxTree()) {
+        egsWarning("EGS_EnvelopeGeometry::setBoundingBoxTree: none of the "
+                   "inscribed geometries of %s has a bounding box,\n"
+                   "  the bounding box tree is not used\n",name.c_str());
+    }
+}
+
 void EGS_EnvelopeGeometry::printInfo() const {
     EGS_BaseGeometry::printInfo();
     egsInformation(" base geometry = %s (type %s)\n",g->getName().c_str(),
@@ -321,6 +373,10 @@ void EGS_EnvelopeGeometry::printInfo() const {
     egsInformation(" inscribed geometries:\n");
     for (int j=0; j<n_in; j++) egsInformation("   %s (type %s)\n",
                 geometries[j]->getName().c_str(),geometries[j]->getType().c_str());
+    if (bbox_tree) {
+        egsInformation(" bounding box tree: %d of %d inscribed geometries"
+                       " with a box\n",bbox_tree->nBounded(),n_in);
+    }
     egsInformation(
         "=======================================================\n");
 }
@@ -488,9 +544,10 @@ extern "C" {
             new EGS_EnvelopeGeometry(g,fgeoms,geoms) :
             new EGS_EnvelopeGeometry(g,geoms);
             */
-        EGS_BaseGeometry *result = new EGS_EnvelopeGeometry(g,geoms,"",indexing);
+        EGS_EnvelopeGeometry *result = new EGS_EnvelopeGeometry(g,geoms,"",indexing);
         result->setName(input);
         result->setLabels(input);
+        result->setBoundingBoxTree(input);
         return result;
 
     }
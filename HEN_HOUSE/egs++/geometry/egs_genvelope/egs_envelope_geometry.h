@@ -65,6 +65,7 @@
 
 #include "egs_base_geometry.h"
 #include "egs_functions.h"
+#include "egs_bounding_box.h"
 
 #include<vector>
 using std::vector;
@@ -178,6 +179,24 @@ The above should be self explanatory. Example geometry files making
 use of an envelope geometry are <code>car.geom, chambers_in_box.geom,
 rz1.geom, seeds_in_xyz.geom</code> and \c seeds_in_xyz1.geom.
 
+With many inscribed geometries, checking all of them in every howfar() and
+hownear() call can dominate the simulation time. The optional key
+\verbatim
+bounding box tree = yes
+\endverbatim
+makes the envelope build, at initialization, a bounding volume hierarchy
+(EGS_BoundingBoxTree) over the bounding boxes of the inscribed geometries.
+A particle in the envelope then only checks the inscribed geometries whose
+box is crossed by the current step (howfar()) or is closer than the
+distance to the envelope boundaries (hownear()). Inscribed geometries
+without a known bounding box (see EGS_BaseGeometry::getBoundingBox()) are
+always checked, so the option is safe to use with any geometry, but it
+only helps if most inscribed geometries are boxes, spheres, sets of
+planes or cylinders, XYZ or N-dimensional geometries, or transformed or
+composite geometries made from them. Because hownear() skips geometries
+that are further away than the envelope boundaries, the distances it
+returns can be larger (but are still safe) than without the tree.
+
 A simple example:
 \verbatim
 :start geometry definition:
@@ -265,7 +284,9 @@ public:
         if (ireg < 0) {
             return ireg;
         }
-        for (int j=0; j<n_in; j++) {
+        int nc = bbox_tree ? bbox_tree->pointCandidates(x,bbox_list) : n_in;
+        for (int k=0; k<nc; k++) {
+            int j = bbox_tree ? bbox_list[k] : k;
             int i = geometries[j]->isWhere(x);
             if (i >= 0) return new_indexing ? local_start[j] + i :
                                    nbase + nmax*j + i;
@@ -345,7 +366,13 @@ public:
                 t = veryFar;
                 int ibase = g->howfar(ireg,x,u,t,&imed);
                 ij = -1;
-                for (int i=0; i<n_in; i++) {
+                int nc = bbox_tree ? bbox_tree->rayCandidates(x,u,t,bbox_list) :
+                         n_in;
+                for (int k=0; k<nc; k++) {
+                    int i = bbox_tree ? bbox_list[k] : k;
+                    if (bbox_tree && !bbox_tree->mayHit(i,x,u,t)) {
+                        continue;
+                    }
                     int ireg_i = geometries[i]->howfar(-1,x,u,t,&imed);
                     if (ireg_i >= 0) {
                         ij = ireg_i;
@@ -427,7 +454,15 @@ public:
                 int ij = -1, jg;
                 // check if we will enter any of the inscribed geometries
                 // before entering a new region in the base geometry.
-                for (int j=0; j<n_in; j++) {
+                // With a bounding box tree, only geometries whose box is
+                // crossed by the step are checked.
+                int nc = bbox_tree ? bbox_tree->rayCandidates(x,u,t,bbox_list) :
+                         n_in;
+                for (int k=0; k<nc; k++) {
+                    int j = bbox_tree ? bbox_list[k] : k;
+                    if (bbox_tree && !bbox_tree->mayHit(j,x,u,t)) {
+                        continue;
+                    }
                     int ireg_j =
                         geometries[j]->howfar(-1,x,u,t,newmed,normal);
                     if (ireg_j >= 0) {
@@ -479,8 +514,11 @@ public:
         if (ienter >= 0) {
             // yes, we do. see if we are already inside of one of the
             // inscribed geometries.
-            for (int j=0; j<n_in; j++) {
-                int i = geometries[j]->isWhere(x+u*t);
+            EGS_Vector xe(x+u*t);
+            int nc = bbox_tree ? bbox_tree->pointCandidates(xe,bbox_list) : n_in;
+            for (int k=0; k<nc; k++) {
+                int j = bbox_tree ? bbox_list[k] : k;
+                int i = geometries[j]->isWhere(xe);
                 if (i >= 0) {
                     // yes, we are.
                     if (newmed) {
@@ -499,7 +537,15 @@ public:
             EGS_Float tmin;
             if (ireg < nbase) {  // in one of the regions of the base geom.
                 tmin = g->hownear(ireg,x);
-                for (int j=0; j<n_in; j++) {
+                // with a bounding box tree, geometries whose box is further
+                // away than tmin can not be closer than tmin.
+                int nc = bbox_tree ? bbox_tree->nearCandidates(x,tmin,bbox_list) :
+                         n_in;
+                for (int k=0; k<nc; k++) {
+                    int j = bbox_tree ? bbox_list[k] : k;
+                    if (bbox_tree && bbox_tree->distance(j,x) >= tmin) {
+                        continue;
+                    }
                     EGS_Float tj = geometries[j]->hownear(-1,x);
                     if (tj < tmin) {
                         tmin = tj;
@@ -599,6 +645,24 @@ public:
         return geometries;
     }
 
+    bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+        return g->getBoundingBox(xmin,xmax);
+    };
+
+    /*! \brief Reads the bounding box tree option from \a input
+
+     Builds a bounding box tree over the inscribed geometries if
+     the input contains <code>bounding box tree = yes</code>.
+    */
+    void setBoundingBoxTree(EGS_Input *input);
+
+    /*! \brief Builds (or rebuilds) the bounding box tree
+
+     Returns the number of inscribed geometries with a bounding box.
+     If none of them has one, the tree is not used.
+    */
+    int buildBoundingBoxTree();
+
     void printInfo() const;
 
     void setRelativeRho(int start, int end, EGS_Float rho);
@@ -643,6 +707,9 @@ protected:
     int *reg_to_inscr;        //!< Region to inscribed geometry conversion
     int *local_start;         //!< First region for each inscribed geometry
 
+    EGS_BoundingBoxTree *bbox_tree; //!< Inscribed geometry boxes, if used
+    int *bbox_list;           //!< Candidate list for bbox_tree queries
+
     /*! \brief Don't set media for an envelope geometry
 
     This function is re-implemented to warn the user to not set media
@@ -1029,6 +1096,10 @@ public:
         return nstep+n_in;
     };
 
+    bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+        return g->getBoundingBox(xmin,xmax);
+    };
+
     const string &getType() const {
         return type;
     };
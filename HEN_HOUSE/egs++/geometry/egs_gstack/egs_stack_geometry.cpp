@@ -45,7 +45,8 @@
 string EGS_StackGeometry::type = "EGS_StackGeometry";
 
 EGS_StackGeometry::EGS_StackGeometry(const vector<EGS_BaseGeometry *> &geoms,
-                                     const string &Name) : EGS_BaseGeometry(Name) {
+                                     const string &Name) : EGS_BaseGeometry(Name),
+    bbox_tree(0), bbox_list(0) {
     if (geoms.size() < 2) egsFatal("EGS_StackGeometry::EGS_StackGeometry: "
                                        " less than 2 geometries is not mermitted\n");
     ng = geoms.size();
@@ -80,6 +81,10 @@ EGS_StackGeometry::EGS_StackGeometry(const vector<EGS_BaseGeometry *> &geoms,
 }
 
 EGS_StackGeometry::~EGS_StackGeometry() {
+    if (bbox_tree) {
+        delete bbox_tree;
+        delete [] bbox_list;
+    }
     for (int j=0; j<ng; j++)
         if (!g[j]->deref()) {
             delete g[j];
@@ -87,11 +92,67 @@ EGS_StackGeometry::~EGS_StackGeometry() {
     delete [] g;
 }
 
+bool EGS_StackGeometry::getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+    xmin = EGS_Vector(veryFar,veryFar,veryFar);
+    xmax = EGS_Vector(-veryFar,-veryFar,-veryFar);
+    for (int j=0; j<ng; j++) {
+        EGS_Vector amin, amax;
+        if (!g[j]->getBoundingBox(amin,amax)) {
+            return false;
+        }
+        EGS_BoundingBoxTree::mergeBox(amin,amax,xmin,xmax);
+    }
+    return true;
+}
+
+int EGS_StackGeometry::buildBoundingBoxTree() {
+    if (bbox_tree) {
+        delete bbox_tree;
+        delete [] bbox_list;
+        bbox_tree = 0;
+        bbox_list = 0;
+    }
+    EGS_Float tol = boundaryTolerance;
+    for (int j=0; j<ng; j++) {
+        if (g[j]->getBoundaryTolerance() > tol) {
+            tol = g[j]->getBoundaryTolerance();
+        }
+    }
+    EGS_BoundingBoxTree *tree = new EGS_BoundingBoxTree;
+    tree->build(ng,g,tol);
+    int nbox = tree->nBounded();
+    if (!nbox) {
+        delete tree;
+        return 0;
+    }
+    bbox_tree = tree;
+    bbox_list = new int [ng];
+    return nbox;
+}
+
+void EGS_StackGeometry::setBoundingBoxTree(EGS_Input *input) {
+    if (!input) {
+        return;
+    }
+    vector<string> options;
+    options.push_back("no");
+    options.push_back("yes");
+    int use_tree = input->getInput("bounding box tree",options,0);
+    if (use_tree && !buildBoundingBoxTree()) {
+        egsWarning("EGS_StackGeometry::setBoundingBoxTree: none of the "
+                   "geometries of %s has a bounding box\n",name.c_str());
+    }
+}
+
 void EGS_StackGeometry::printInfo() const {
     EGS_BaseGeometry::printInfo();
     egsInformation(" geometries:\n");
     for (int j=0; j<ng; j++) egsInformation("   %s (type %s)\n",
                                                 g[j]->getName().c_str(),g[j]->getType().c_str());
+    if (bbox_tree) {
+        egsInformation(" bounding box tree: %d of %d geometries with a box\n",
+                       bbox_tree->nBounded(),ng);
+    }
     egsInformation(
         "=======================================================\n");
 }
@@ -147,7 +208,7 @@ extern "C" {
             egsWarning("createGeometry(stack): must have at least 2 geometries\n");
             return 0;
         }
-        EGS_BaseGeometry *result = new EGS_StackGeometry(geoms);
+        EGS_StackGeometry *result = new EGS_StackGeometry(geoms);
         result->setName(input);
         result->setBoundaryTolerance(input);
         result->setLabels(input);
@@ -156,6 +217,7 @@ extern "C" {
         if (!err) {
             result->setBoundaryTolerance(tol);
         }
+        result->setBoundingBoxTree(input);
         return result;
     }
 
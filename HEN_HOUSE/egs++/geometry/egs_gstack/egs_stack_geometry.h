@@ -63,6 +63,7 @@
 
 
 #include "egs_base_geometry.h"
+#include "egs_bounding_box.h"
 #include "egs_functions.h"
 
 #include<vector>
@@ -169,6 +170,17 @@ A simple example:
 :stop geometry definition:
 \endverbatim
 \image html egs_gstack.png "A simple example with clipping plane 1,0,0,0"
+
+For stacks of many geometries the optional key
+\verbatim
+bounding box tree = yes
+\endverbatim
+arranges the bounding boxes of the stacked geometries (see
+EGS_BaseGeometry::getBoundingBox()) in an EGS_BoundingBoxTree, so that
+isWhere() and isInside() only query the geometries whose box contains
+the position. howfar() and hownear() from outside skip the first or
+last geometry when its box is not crossed by the step or is further
+away than the other estimate.
 */
 class EGS_StackGeometry : public EGS_BaseGeometry {
 
@@ -191,14 +203,20 @@ public:
     };
 
     bool isInside(const EGS_Vector &x) {
-        for (int j=0; j<ng; j++) if (g[j]->isInside(x)) {
+        int nc = bbox_tree ? bbox_tree->pointCandidates(x,bbox_list) : ng;
+        for (int k=0; k<nc; k++) {
+            int j = bbox_tree ? bbox_list[k] : k;
+            if (g[j]->isInside(x)) {
                 return true;
             }
+        }
         return false;
     };
 
     int isWhere(const EGS_Vector &x) {
-        for (int j=0; j<ng; j++) {
+        int nc = bbox_tree ? bbox_tree->pointCandidates(x,bbox_list) : ng;
+        for (int k=0; k<nc; k++) {
+            int j = bbox_tree ? bbox_list[k] : k;
             int i = g[j]->isWhere(x);
             if (i >= 0) {
                 return nmax*j + i;
@@ -254,8 +272,13 @@ public:
             t -= boundaryTolerance;
             return -1;
         }
-        int i1 = g[0]->howfar(-1,x,u,t,newmed,normal);
-        int i2 = g[ng-1]->howfar(-1,x,u,t,newmed,normal);
+        int i1 = -1, i2 = -1;
+        if (!bbox_tree || bbox_tree->mayHit(0,x,u,t)) {
+            i1 = g[0]->howfar(-1,x,u,t,newmed,normal);
+        }
+        if (!bbox_tree || bbox_tree->mayHit(ng-1,x,u,t)) {
+            i2 = g[ng-1]->howfar(-1,x,u,t,newmed,normal);
+        }
         if (i2 >= 0) {
             return (ng-1)*nmax + i2;
         }
@@ -271,6 +294,9 @@ public:
             return g[jg]->hownear(ireg-jg*nmax,x);
         }
         EGS_Float t1 = g[0]->hownear(-1,x);
+        if (bbox_tree && bbox_tree->distance(ng-1,x) >= t1) {
+            return t1;
+        }
         EGS_Float t2 = g[ng-1]->hownear(-1,x);
         if (t2 < t1) {
             return t2;
@@ -298,6 +324,22 @@ public:
         setPropertError("addBooleanProperty()");
     };
 
+    /*! \brief The union of the boxes of all stacked geometries
+
+     Returns false if any of the geometries has no bounding box.
+    */
+    bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax);
+
+    /*! \brief Reads the bounding box tree option from \a input */
+    void setBoundingBoxTree(EGS_Input *input);
+
+    /*! \brief Builds (or rebuilds) the bounding box tree
+
+     Returns the number of geometries with a bounding box. If none of them
+     has one, the tree is not used.
+    */
+    int buildBoundingBoxTree();
+
     const string &getType() const {
         return type;
     };
@@ -333,6 +375,9 @@ protected:
     EGS_BaseGeometry **g;
     static string    type;
 
+    EGS_BoundingBoxTree *bbox_tree; //!< boxes of the geometries, if used
+    int              *bbox_list;    //!< candidate list for bbox_tree queries
+
     void setMedia(EGS_Input *,int,const int *);
 
     vector<label> stack_labels;
@@ -42,6 +42,7 @@
 
 #include "egs_base_geometry.h"
 #include "egs_transformations.h"
+#include "egs_bounding_box.h"
 
 #ifdef WIN32
 
@@ -196,7 +197,13 @@ public:
 
     EGS_Float howfarToOutside(int ireg, const EGS_Vector &x,
                               const EGS_Vector &u) {
-        return ireg >= 0 ? g->howfarToOutside(ireg,x*T,u*T.getRotation()) : 0;
+        if (ireg < 0) {
+            return 0;
+        }
+        EGS_Vector xt(x), ut(u);
+        T.inverseTransform(xt);
+        T.rotateInverse(ut);
+        return g->howfarToOutside(ireg,xt,ut);
     };
     int howfar(int ireg, const EGS_Vector &x, const EGS_Vector &u,
                EGS_Float &t, int *newmed=0, EGS_Vector *normal=0) {
@@ -206,7 +213,7 @@ public:
         int inew = g->howfar(ireg,xt,ut,t,newmed,normal);
         //int inew = g->howfar(ireg,x*T,u*T.getRotation(),t,newmed,normal);
         if (inew != ireg && normal) {
-            *normal = T.getRotation()*(*normal);
+            T.rotate(*normal);
         }
         return inew;
     };
@@ -243,6 +250,14 @@ public:
         return g->getMaxStep();
     };
 
+    bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+        if (!g->getBoundingBox(xmin,xmax)) {
+            return false;
+        }
+        EGS_BoundingBoxTree::transformBox(T,xmin,xmax);
+        return true;
+    };
+
     // Not sure about the following.
     // If I leave the implementation that way, all transformed copies of a
     // geometry share the same boolean properties. But that may not be
@@ -45,6 +45,7 @@
 #include "egs_input.h"
 #include "egs_functions.h"
 #include "egs_transformations.h"
+#include "egs_application.h"
 
 #ifdef HAS_GZSTREAM
     #include "gzstream.h"
@@ -162,7 +163,8 @@ string EGS_XYZGeometry::type = "EGS_XYZGeometry";
 
 EGS_XYZGeometry::EGS_XYZGeometry(EGS_PlanesX *Xp, EGS_PlanesY *Yp,
                                  EGS_PlanesZ *Zp, const string &Name) : EGS_BaseGeometry(Name),
-    xp(Xp), yp(Yp), zp(Zp) {
+    xp(Xp), yp(Yp), zp(Zp), mc_size(0), mcx(0), mcy(0), mcz(0), mcxy(0),
+    mc_homogeneous(0), mc_active(false) {
     nx = xp->regions();
     ny = yp->regions();
     nz = zp->regions();
@@ -186,10 +188,23 @@ EGS_XYZGeometry::~EGS_XYZGeometry() {
     if (!zp->deref()) {
         delete zp;
     }
+    if (mc_homogeneous) {
+        delete [] mc_homogeneous;
+    }
 }
 
 void EGS_XYZGeometry::printInfo() const {
     EGS_BaseGeometry::printInfo();
+    if (mc_homogeneous) {
+        int nhom = 0, nmc = mcxy*mcz;
+        for (int j=0; j<nmc; j++) {
+            if (mc_homogeneous[j]) {
+                nhom++;
+            }
+        }
+        egsInformation(" macro-cell skipping: %d^3 voxel blocks, %d of %d "
+                       "homogeneous\n",mc_size,nhom,nmc);
+    }
     xp->printInfo();
     yp->printInfo();
     zp->printInfo();
@@ -1003,7 +1018,7 @@ void EGS_XYZGeometry::voxelizeGeometry(EGS_Input *input) {
     bool hrs = geometry->hasRhoScaling();
     if (hrs) {
         has_rho_scaling = true;
-        rhor = new EGS_Float [nreg];
+        rhor = new EGS_RegionFloat [nreg];
     }
     else {
         has_rho_scaling = false;
@@ -1012,7 +1027,7 @@ void EGS_XYZGeometry::voxelizeGeometry(EGS_Input *input) {
     bool hbs = geometry->hasBScaling();
     if (hbs) {
         has_B_scaling = true;
-        bfactor = new EGS_Float [nreg];
+        bfactor = new EGS_RegionFloat [nreg];
     }
     else {
         has_B_scaling = false;
@@ -1075,6 +1090,78 @@ void EGS_XYZGeometry::voxelizeGeometry(EGS_Input *input) {
     egsInformation("\n");
 }
 
+void EGS_XYZGeometry::setMacroCells(EGS_Input *input) {
+    vector<string> options;
+    options.push_back("no");
+    options.push_back("yes");
+    bool skip = input->getInput("macro-cell skipping",options,0);
+    if (!skip) {
+        return;
+    }
+    int size = 8;
+    int err = input->getInput("macro-cell size",size);
+    if (!err && size < 1) {
+        egsWarning("EGS_XYZGeometry::setMacroCells: macro-cell size must be "
+                   "positive, using 8\n");
+        size = 8;
+    }
+    buildMacroCells(size);
+    enableMacroCells(true);
+}
+
+bool EGS_XYZGeometry::neutralParticle() const {
+    EGS_Application *app = EGS_Application::activeApplication();
+    return !app || app->top_p.q == 0;
+}
+
+int EGS_XYZGeometry::buildMacroCells(int size) {
+    if (mc_homogeneous) {
+        delete [] mc_homogeneous;
+    }
+    mc_size = size;
+    mcx = (nx + size - 1)/size;
+    mcy = (ny + size - 1)/size;
+    mcz = (nz + size - 1)/size;
+    mcxy = mcx*mcy;
+    int nmc = mcxy*mcz;
+    mc_homogeneous = new char [nmc];
+    int nhom = 0;
+    for (int kz=0; kz<mcz; kz++) {
+        int iz2 = min((kz+1)*size,nz);
+        for (int ky=0; ky<mcy; ky++) {
+            int iy2 = min((ky+1)*size,ny);
+            for (int kx=0; kx<mcx; kx++) {
+                int ix2 = min((kx+1)*size,nx);
+                int ifirst = kx*size + ky*size*nx + kz*size*nxy;
+                int imed = medium(ifirst);
+                EGS_Float rho = getRelativeRho(ifirst);
+                bool hom = true;
+                for (int iz=kz*size; iz<iz2 && hom; iz++) {
+                    for (int iy=ky*size; iy<iy2 && hom; iy++) {
+                        for (int ix=kx*size; ix<ix2; ix++) {
+                            int ireg = ix + iy*nx + iz*nxy;
+                            if (medium(ireg) != imed ||
+                                    getRelativeRho(ireg) != rho) {
+                                hom = false;
+                                break;
+                            }
+                        }
+                    }
+                }
+                // a single voxel block gains nothing
+                if (ix2-kx*size == 1 && iy2-ky*size == 1 && iz2-kz*size == 1) {
+                    hom = false;
+                }
+                mc_homogeneous[kx + ky*mcx + kz*mcxy] = hom ? 1 : 0;
+                if (hom) {
+                    nhom++;
+                }
+            }
+        }
+    }
+    return nhom;
+}
+
 const char *err_msg1 = "createGeometry(EGS_XYZRepeater)";
 
 #endif
@@ -1193,6 +1280,7 @@ extern "C" {
                     result->setName(input);
                     result->setBoundaryTolerance(input);
                     result->setBScaling(input);
+                    result->setMacroCells(input);
                 }
 
                 return result;
@@ -1298,6 +1386,7 @@ extern "C" {
                 result->setBoundaryTolerance(input);
                 g->setMedia(input);
                 result->voxelizeGeometry(input);
+                result->setMacroCells(input);
 
                 // labels
                 result->setXYZLabels(input);
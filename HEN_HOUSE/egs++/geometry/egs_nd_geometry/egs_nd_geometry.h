@@ -68,6 +68,7 @@
 
 
 #include "egs_base_geometry.h"
+#include "egs_bounding_box.h"
 
 #include<vector>
 #include <iomanip>
@@ -583,6 +584,25 @@ public:
         }
     };
 
+    /*! \brief The intersection of the bounding boxes of the dimensions
+
+      Dimensions without a bounding box are ignored. Returns false if none
+      of the dimensions has one.
+     */
+    bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+        bool has_box = false;
+        xmin = EGS_Vector(-veryFar,-veryFar,-veryFar);
+        xmax = EGS_Vector(veryFar,veryFar,veryFar);
+        for (int j=0; j<N; j++) {
+            EGS_Vector amin, amax;
+            if (g[j]->getBoundingBox(amin,amax)) {
+                EGS_BoundingBoxTree::intersectBox(amin,amax,xmin,xmax);
+                has_box = true;
+            }
+        }
+        return has_box;
+    };
+
     const string &getType() const {
         return type;
     };
@@ -729,6 +749,30 @@ geometry, \c Dx is the uniform slab thickness, and \c Nx is the number of slabs
 (similarly for the y and z axes). The number of regions along x is \c Nx and
 the maximum x boundary is thus <code>Xo + Nx*Dx</code>.
 
+The region by region stepping of an XYZ geometry can become the
+dominant cost of a simulation when large portions of the geometry are
+homogeneous (e.g., the air surrounding a patient, or a water tank).
+For such cases one can request macro-cell skipping by adding
+\verbatim
+macro-cell skipping = yes
+macro-cell size = N
+\endverbatim
+to the geometry definition. The voxels are then grouped into blocks
+of N x N x N voxels (default N=8) and blocks in which all voxels have
+the same medium and relative mass density are marked homogeneous.
+When a photon is in a homogeneous block, howfar() computes the distance
+to the boundary of the block instead of the voxel and returns the voxel
+in which the photon ends up at the end of the step (or the voxel entered
+when leaving the block). The region reported at the end of each step is
+therefore always correct, but a single step may traverse several voxels.
+Charged particles, which deposit energy along their steps, are always
+transported voxel by voxel. The charge is taken from the particle being
+transported by the active application (see EGS_Application::top_p);
+without an active application (e.g., when ray tracing in egs_view) all
+particles are treated as photons. Tracklength estimators in individual
+voxels see one long photon step, applications using such estimators can
+switch the skipping off with enableMacroCells().
+
 A simple example:
 \verbatim
 :start geometry definition:
@@ -967,6 +1011,12 @@ public:
             int ir = ireg - iz*nxy;
             int iy = ir/nx;
             int ix = ir - iy*nx;
+            if (mc_active) {
+                int imc = ix/mc_size + (iy/mc_size)*mcx + (iz/mc_size)*mcxy;
+                if (mc_homogeneous[imc] && neutralParticle()) {
+                    return howfarInMacroCell(ix,iy,iz,x,u,t,newmed,normal);
+                }
+            }
             int inew = ireg;
             if (u.x > 0) {
                 EGS_Float d = (xpos[ix+1]-x.x)/u.x;
@@ -1238,12 +1288,47 @@ public:
 
     static int getDigits(int i);
 
+    bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+        xmin = EGS_Vector(xpos[0],ypos[0],zpos[0]);
+        xmax = EGS_Vector(xpos[nx],ypos[ny],zpos[nz]);
+        return true;
+    };
+
     const string &getType() const {
         return type;
     };
 
     void printInfo() const;
 
+    /*! \brief Reads the macro-cell skipping options from \a input
+
+     Groups the voxels into blocks of <code>macro-cell size</code> voxels
+     in each dimension and marks the blocks in which all voxels have the
+     same medium and relative mass density. Must be called after the
+     media and mass densities have been set. Skipping is only activated
+     if the input contains <code>macro-cell skipping = yes</code>.
+    */
+    void setMacroCells(EGS_Input *input);
+
+    /*! \brief Builds the macro-cell table using blocks of \a size voxels
+
+     Returns the number of homogeneous macro-cells.
+    */
+    int buildMacroCells(int size);
+
+    /*! \brief Turns macro-cell skipping on or off
+
+     Has no effect if the macro-cell table has not been built.
+    */
+    void enableMacroCells(bool enable) {
+        mc_active = enable && mc_homogeneous;
+    };
+
+    /*! \brief Is macro-cell skipping currently in use? */
+    bool macroCellsEnabled() const {
+        return mc_active;
+    };
+
     static EGS_XYZGeometry *constructGeometry(const char *dens_or_egphant_file,
             const char *ramp_file, int dens_or_egphant=0);
     static EGS_XYZGeometry *constructCTGeometry(const char *dens_or_egphant_file);
@@ -1274,8 +1359,161 @@ protected:
     int              nx, ny, nz, nxy;
     static string    type;
 
+    /*! Macro-cell skipping data (see setMacroCells()) */
+    int              mc_size;         //!< Voxels per macro-cell and dimension
+    int              mcx, mcy, mcz;   //!< Number of macro-cells per dimension
+    int              mcxy;            //!< mcx*mcy
+    char             *mc_homogeneous; //!< 1 for homogeneous macro-cells
+    bool             mc_active;       //!< Is skipping currently in use?
+
     void setup();
 
+    /*! \brief Returns the voxel index in [\a i1, \a i2) containing \a p
+
+     \a pos are the plane positions. The result is clamped to the range,
+     which takes care of end points that are off by roundoff.
+    */
+    static inline int findVoxel(const EGS_Float *pos, int i1, int i2,
+                                EGS_Float p) {
+        while (i2 - i1 > 1) {
+            int im = (i1 + i2)/2;
+            if (p < pos[im]) {
+                i2 = im;
+            }
+            else {
+                i1 = im;
+            }
+        }
+        return i1;
+    };
+
+    /*! \brief Is the particle being transported neutral?
+
+     Macro-cell skipping is only used for neutral particles. Returns true
+     if there is no active application.
+    */
+    bool neutralParticle() const;
+
+    /*! \brief howfar() for a particle in the homogeneous macro-cell
+     containing voxel (\a ix, \a iy, \a iz)
+
+     The step is limited by the macro-cell boundaries only. The returned
+     region is the voxel in which the particle ends the step or, if the step
+     was shortened, the voxel entered after leaving the macro-cell.
+    */
+    int howfarInMacroCell(int ix, int iy, int iz, const EGS_Vector &x,
+                          const EGS_Vector &u, EGS_Float &t, int *newmed,
+                          EGS_Vector *normal) {
+        int ix1 = (ix/mc_size)*mc_size, ix2 = ix1 + mc_size;
+        int iy1 = (iy/mc_size)*mc_size, iy2 = iy1 + mc_size;
+        int iz1 = (iz/mc_size)*mc_size, iz2 = iz1 + mc_size;
+        if (ix2 > nx) {
+            ix2 = nx;
+        }
+        if (iy2 > ny) {
+            iy2 = ny;
+        }
+        if (iz2 > nz) {
+            iz2 = nz;
+        }
+        // exit: 0 = stays in the macro-cell, 1,2,3 = leaves through x,y,z
+        int exit = 0, inext = 0;
+        if (u.x > 0) {
+            EGS_Float d = (xpos[ix2]-x.x)/u.x;
+            if (d <= t) {
+                t = d <= boundaryTolerance ? halfBoundaryTolerance : d;
+                exit = 1;
+                inext = ix2;
+            }
+        }
+        else if (u.x < 0) {
+            EGS_Float d = (xpos[ix1]-x.x)/u.x;
+            if (d <= t) {
+                t = d <= boundaryTolerance ? halfBoundaryTolerance : d;
+                exit = 1;
+                inext = ix1-1;
+            }
+        }
+        if (u.y > 0) {
+            EGS_Float d = (ypos[iy2]-x.y)/u.y;
+            if (d <= t) {
+                t = d <= boundaryTolerance ? halfBoundaryTolerance : d;
+                exit = 2;
+                inext = iy2;
+            }
+        }
+        else if (u.y < 0) {
+            EGS_Float d = (ypos[iy1]-x.y)/u.y;
+            if (d <= t) {
+                t = d <= boundaryTolerance ? halfBoundaryTolerance : d;
+                exit = 2;
+                inext = iy1-1;
+            }
+        }
+        if (u.z > 0) {
+            EGS_Float d = (zpos[iz2]-x.z)/u.z;
+            if (d <= t) {
+                t = d <= boundaryTolerance ? halfBoundaryTolerance : d;
+                exit = 3;
+                inext = iz2;
+            }
+        }
+        else if (u.z < 0) {
+            EGS_Float d = (zpos[iz1]-x.z)/u.z;
+            if (d <= t) {
+                t = d <= boundaryTolerance ? halfBoundaryTolerance : d;
+                exit = 3;
+                inext = iz1-1;
+            }
+        }
+        if (normal && exit) {
+            if (exit == 1) {
+                *normal = EGS_Vector(u.x > 0 ? -1 : 1,0,0);
+            }
+            else if (exit == 2) {
+                *normal = EGS_Vector(0,u.y > 0 ? -1 : 1,0);
+            }
+            else {
+                *normal = EGS_Vector(0,0,u.z > 0 ? -1 : 1);
+            }
+        }
+        // locate the end point within the macro-cell along the directions
+        // not crossed
+        EGS_Vector xe(x + u*t);
+        if (exit == 1) {
+            if (inext < 0 || inext >= nx) {
+                return -1;
+            }
+            ix = inext;
+        }
+        else if (u.x) {
+            ix = findVoxel(xpos,ix1,ix2,xe.x);
+        }
+        if (exit == 2) {
+            if (inext < 0 || inext >= ny) {
+                return -1;
+            }
+            iy = inext;
+        }
+        else if (u.y) {
+            iy = findVoxel(ypos,iy1,iy2,xe.y);
+        }
+        if (exit == 3) {
+            if (inext < 0 || inext >= nz) {
+                return -1;
+            }
+            iz = inext;
+        }
+        else if (u.z) {
+            iz = findVoxel(zpos,iz1,iz2,xe.z);
+        }
+        int inew = ix + iy*nx + iz*nxy;
+        if (newmed) {
+            *newmed = medium(inew);
+        }
+        return inew;
+    };
+
     void setMedia(EGS_Input *inp, int nmed, const int *med_ind);
 
     int howfarFromOut(const EGS_Vector &x, const EGS_Vector &u,
@@ -1592,6 +1830,12 @@ public:
         return 6*(nx+ny+nz) + 1;
     };
 
+    /*! \brief The deformed voxels may extend outside of the undeformed
+      grid, so no box is available. */
+    bool getBoundingBox(EGS_Vector &, EGS_Vector &) {
+        return false;
+    };
+
     const string &getType() const {
         return def_type;
     };
@@ -1915,6 +2159,10 @@ public:
         return nxyz*(g->getMaxStep() + 1) + 1;
     };
 
+    bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+        return xyz->getBoundingBox(xmin,xmax);
+    };
+
     const string &getType() const {
         return type;
     };
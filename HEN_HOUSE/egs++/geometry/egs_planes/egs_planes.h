@@ -454,6 +454,41 @@ public:
         return 0; // this should not happen.
     };
 
+    /*! \brief The slab between the first and last plane
+
+      A set of planes is only bounded along its normal, so a box is
+      available only when the normal is parallel to one of the axes.
+     */
+    bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+        EGS_Vector n = a.normal();
+        xmin = EGS_Vector(-veryFar,-veryFar,-veryFar);
+        xmax = EGS_Vector(veryFar,veryFar,veryFar);
+        EGS_Float nj;
+        EGS_Float *cmin, *cmax;
+        if (!n.y && !n.z && n.x) {
+            nj = n.x;
+            cmin = &xmin.x;
+            cmax = &xmax.x;
+        }
+        else if (!n.x && !n.z && n.y) {
+            nj = n.y;
+            cmin = &xmin.y;
+            cmax = &xmax.y;
+        }
+        else if (!n.x && !n.y && n.z) {
+            nj = n.z;
+            cmin = &xmin.z;
+            cmax = &xmax.z;
+        }
+        else {
+            return false;
+        }
+        EGS_Float c1 = p[0]/nj, c2 = p_last/nj;
+        *cmin = c1 < c2 ? c1 : c2;
+        *cmax = c1 < c2 ? c2 : c1;
+        return true;
+    };
+
     const string &getType() const {
         return a.getType();
     };
@@ -188,6 +188,17 @@ public:
     /*! \brief Implement getVolume for spherical regions */
     EGS_Float getVolume(int ireg);
 
+    /*! \brief The box enclosing the outer sphere */
+    bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+        if (nreg < 1) {
+            return false;
+        }
+        EGS_Float r = R[nreg-1];
+        xmin = xo - EGS_Vector(r,r,r);
+        xmax = xo + EGS_Vector(r,r,r);
+        return true;
+    };
+
 private:
 
     EGS_Float *R2;                // radius^2
@@ -252,6 +263,16 @@ public:
 
     EGS_Float getVolume(int ireg);
 
+    bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+        if (nreg < 1) {
+            return false;
+        }
+        EGS_Float r = R[nreg];
+        xmin = xo - EGS_Vector(r,r,r);
+        xmax = xo + EGS_Vector(r,r,r);
+        return true;
+    };
+
 private:
 
     EGS_Float *R2;                // radius^2
@@ -72,7 +72,7 @@ void EGS_UnionGeometry::setBScaling(EGS_Input *) {
 
 EGS_UnionGeometry::EGS_UnionGeometry(const vector<EGS_BaseGeometry *> &geoms,
                                      const int *priorities, const string &Name) :
-    EGS_BaseGeometry(Name) {
+    EGS_BaseGeometry(Name), bbox_tree(0), bbox_list(0) {
     ng = geoms.size();
     if (ng <= 0) egsFatal("EGS_UnionGeometry::EGS_UnionGeometry: attempt "
                               " to construct a union geometry from zero geometries\n");
@@ -150,6 +150,10 @@ EGS_UnionGeometry::EGS_UnionGeometry(const vector<EGS_BaseGeometry *> &geoms,
 }
 
 EGS_UnionGeometry::~EGS_UnionGeometry() {
+    if (bbox_tree) {
+        delete bbox_tree;
+        delete [] bbox_list;
+    }
     for (int j=0; j<ng; j++) {
         if (!g[j]->deref()) {
             delete g[j];
@@ -158,11 +162,67 @@ EGS_UnionGeometry::~EGS_UnionGeometry() {
     delete [] g;
 }
 
+bool EGS_UnionGeometry::getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax) {
+    xmin = EGS_Vector(veryFar,veryFar,veryFar);
+    xmax = EGS_Vector(-veryFar,-veryFar,-veryFar);
+    for (int j=0; j<ng; j++) {
+        EGS_Vector amin, amax;
+        if (!g[j]->getBoundingBox(amin,amax)) {
+            return false;
+        }
+        EGS_BoundingBoxTree::mergeBox(amin,amax,xmin,xmax);
+    }
+    return true;
+}
+
+int EGS_UnionGeometry::buildBoundingBoxTree() {
+    if (bbox_tree) {
+        delete bbox_tree;
+        delete [] bbox_list;
+        bbox_tree = 0;
+        bbox_list = 0;
+    }
+    EGS_Float tol = boundaryTolerance;
+    for (int j=0; j<ng; j++) {
+        if (g[j]->getBoundaryTolerance() > tol) {
+            tol = g[j]->getBoundaryTolerance();
+        }
+    }
+    EGS_BoundingBoxTree *tree = new EGS_BoundingBoxTree;
+    tree->build(ng,g,tol);
+    int nbox = tree->nBounded();
+    if (!nbox) {
+        delete tree;
+        return 0;
+    }
+    bbox_tree = tree;
+    bbox_list = new int [ng];
+    return nbox;
+}
+
+void EGS_UnionGeometry::setBoundingBoxTree(EGS_Input *input) {
+    if (!input) {
+        return;
+    }
+    vector<string> options;
+    options.push_back("no");
+    options.push_back("yes");
+    int use_tree = input->getInput("bounding box tree",options,0);
+    if (use_tree && !buildBoundingBoxTree()) {
+        egsWarning("EGS_UnionGeometry::setBoundingBoxTree: none of the "
+                   "geometries of %s has a bounding box\n",name.c_str());
+    }
+}
+
 void EGS_UnionGeometry::printInfo() const {
     EGS_BaseGeometry::printInfo();
     egsInformation(" geometries:\n");
     for (int j=0; j<ng; j++) egsInformation("   %s (type %s)\n",
                                                 g[j]->getName().c_str(),g[j]->getType().c_str());
+    if (bbox_tree) {
+        egsInformation(" bounding box tree: %d of %d geometries with a box\n",
+                       bbox_tree->nBounded(),ng);
+    }
     egsInformation(
         "=======================================================\n");
 }
@@ -207,9 +267,10 @@ extern "C" {
                                 " is not the same as the number of geometries (%d) => ignoring\n",
                                 pri.size(),geoms.size());
         }
-        EGS_BaseGeometry *result = new EGS_UnionGeometry(geoms,p);
+        EGS_UnionGeometry *result = new EGS_UnionGeometry(geoms,p);
         result->setName(input);
         result->setBoundaryTolerance(input);
+        result->setBoundingBoxTree(input);
         result->setLabels(input);
         if (p) {
             delete [] p;
@@ -63,6 +63,7 @@
 
 
 #include "egs_base_geometry.h"
+#include "egs_bounding_box.h"
 
 #include<vector>
 using std::vector;
@@ -95,6 +96,20 @@ defined, \f$G_i\f$ is still considered to have a higher priority if
 \f$i < j\f$. A geometry union is used in the \c car.geom example
 geometry file.
 
+For unions of many geometries (\em e.g. a collimator made from hundreds
+of leaves), the optional key
+\verbatim
+bounding box tree = yes
+\endverbatim
+computes the bounding boxes of the constituent geometries at
+initialization (see EGS_BaseGeometry::getBoundingBox()) and arranges them
+in an EGS_BoundingBoxTree. isWhere(), isInside() and howfar() then only
+query the geometries whose box contains the position or is crossed by
+the step, and hownear() skips geometries whose box is further away than
+the current distance estimate (it may therefore return larger, but still
+safe, distances than without the tree). Geometries without a known
+bounding box are always queried.
+
 A simple example:
 \verbatim
 :start geometry definition:
@@ -152,14 +167,20 @@ public:
     };
 
     bool isInside(const EGS_Vector &x) {
-        for (int j=0; j<ng; j++) if (g[j]->isInside(x)) {
+        int nc = bbox_tree ? bbox_tree->pointCandidates(x,bbox_list) : ng;
+        for (int k=0; k<nc; k++) {
+            int j = bbox_tree ? bbox_list[k] : k;
+            if (g[j]->isInside(x)) {
                 return true;
             }
+        }
         return false;
     };
 
     int isWhere(const EGS_Vector &x) {
-        for (int j=0; j<ng; j++) {
+        int nc = bbox_tree ? bbox_tree->pointCandidates(x,bbox_list) : ng;
+        for (int k=0; k<nc; k++) {
+            int j = bbox_tree ? bbox_list[k] : k;
             int ij = g[j]->isWhere(x);
             if (ij >= 0) {
                 return ij + j*nmax;
@@ -197,7 +218,17 @@ public:
             //     otherwise it would have been in one of them
             //   - if the particle exits the current geometry, then
             //     we must also check jg+1...ng-1
-            for (int j=0; j<jg; j++) {
+            // With a bounding box tree, only geometries whose box is
+            // crossed by the step are checked (the list is sorted).
+            int nc = bbox_tree ? bbox_tree->rayCandidates(x,u,t,bbox_list) : jg;
+            for (int k=0; k<nc; k++) {
+                int j = bbox_tree ? bbox_list[k] : k;
+                if (j >= jg) {
+                    break;
+                }
+                if (bbox_tree && !bbox_tree->mayHit(j,x,u,t)) {
+                    continue;
+                }
                 int ii = g[j]->howfar(-1,x,u,t,newmed,normal);
                 if (ii >= 0) {
                     jgnew = j;
@@ -210,7 +241,13 @@ public:
                 // => we need to check if the particle is in one
                 // of the lower priority geometries at the exit point.
                 EGS_Vector xnew(x+u*t);
-                for (int j=jg+1; j<ng; j++) {
+                int nc = bbox_tree ? bbox_tree->pointCandidates(xnew,bbox_list) :
+                         ng;
+                for (int k=0; k<nc; k++) {
+                    int j = bbox_tree ? bbox_list[k] : k;
+                    if (j <= jg) {
+                        continue;
+                    }
                     int ii = g[j]->isWhere(xnew);
                     if (ii >= 0) {
                         // when exiting jg, particle is in region ii of geometry j
@@ -232,7 +269,12 @@ public:
         }
         // if here, we are currently outside of all geometries in the union.
         int jg, inew=-1;
-        for (int j=0; j<ng; j++) {
+        int nc = bbox_tree ? bbox_tree->rayCandidates(x,u,t,bbox_list) : ng;
+        for (int k=0; k<nc; k++) {
+            int j = bbox_tree ? bbox_list[k] : k;
+            if (bbox_tree && !bbox_tree->mayHit(j,x,u,t)) {
+                continue;
+            }
             int ii = g[j]->howfar(-1,x,u,t,newmed,normal);
             if (ii >= 0) {
                 jg = j;
@@ -255,6 +297,26 @@ public:
             // i.e., all geometries between 0 and jg-1.
             // as their priorities are higher, we know that we are
             // outside of such geometries.
+            if (bbox_tree) {
+                int nc = bbox_tree->nearCandidates(x,tmin,bbox_list);
+                for (int k=0; k<nc; k++) {
+                    int j = bbox_list[k];
+                    if (j >= jg) {
+                        break;
+                    }
+                    if (bbox_tree->distance(j,x) >= tmin) {
+                        continue;
+                    }
+                    EGS_Float t = g[j]->hownear(-1,x);
+                    if (t < tmin) {
+                        tmin = t;
+                        if (tmin <= 0) {
+                            return 0;
+                        }
+                    }
+                }
+                return tmin;
+            }
             for (int j=jg-1; j>=0; --j) {
                 EGS_Float t = g[j]->hownear(-1,x);
                 if (t < tmin) {
@@ -268,6 +330,32 @@ public:
         }
         // if here, we are outside of all geomtries in the union.
         EGS_Float tmin = veryFar;
+        if (bbox_tree) {
+            // start with the geometry with the nearest box and then
+            // check the geometries with boxes closer than tmin.
+            int jn = bbox_tree->nearest(x);
+            if (jn >= 0) {
+                tmin = g[jn]->hownear(-1,x);
+                if (tmin <= 0) {
+                    return 0;
+                }
+            }
+            int nc = bbox_tree->nearCandidates(x,tmin,bbox_list);
+            for (int k=0; k<nc; k++) {
+                int j = bbox_list[k];
+                if (j == jn || bbox_tree->distance(j,x) >= tmin) {
+                    continue;
+                }
+                EGS_Float t = g[j]->hownear(-1,x);
+                if (t < tmin) {
+                    tmin = t;
+                    if (tmin <= 0) {
+                        return 0;
+                    }
+                }
+            }
+            return tmin;
+        }
         for (int j=ng-1; j>=0; j--) {
             EGS_Float t = g[j]->hownear(-1,x);
             if (t < tmin) {
@@ -314,6 +402,26 @@ public:
         return nstep;
     };
 
+    /*! \brief The union of the boxes of all geometries
+
+     Returns false if any of the geometries has no bounding box.
+    */
+    bool getBoundingBox(EGS_Vector &xmin, EGS_Vector &xmax);
+
+    /*! \brief Reads the bounding box tree option from \a input
+
+     Builds a bounding box tree over the geometries in the union if the
+     input contains <code>bounding box tree = yes</code>.
+    */
+    void setBoundingBoxTree(EGS_Input *input);
+
+    /*! \brief Builds (or rebuilds) the bounding box tree
+
+     Returns the number of geometries with a bounding box. If none of them
+     has one, the tree is not used.
+    */
+    int buildBoundingBoxTree();
+
     const string &getType() const {
         return type;
     };
@@ -349,6 +457,9 @@ protected:
     int              nmax;    //!< max. number of regions in all of the geoms.
     static string    type;    //!< the geometry type
 
+    EGS_BoundingBoxTree *bbox_tree; //!< boxes of the geometries, if used
+    int              *bbox_list;    //!< candidate list for bbox_tree queries
+
     /*! \brief Don't set media when defining the union.
 
     This function is re-implemented to warn the user that media should be
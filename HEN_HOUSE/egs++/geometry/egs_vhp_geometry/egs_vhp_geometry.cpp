@@ -71,16 +71,18 @@ using namespace std;
 EGS_VoxelInfo *EGS_VoxelGeometry::v = 0;
 int            EGS_VoxelGeometry::nv = 0;
 
-VHP_OrganData::VHP_OrganData(const char *fname, int slice_min, int slice_max)
-    : nslice(0), ok(false) {
-    ifstream data(fname,ios::binary);
-    if (!data) {
+VHP_OrganData::VHP_OrganData(const char *fname, int slice_min, int slice_max,
+                             int max_loaded_slices)
+    : nslice(0), ok(false), max_loaded(max_loaded_slices), nloaded(0),
+      nuse(0), data(0), offsets(0), loaded(0), last_use(0) {
+    data = new ifstream(fname,ios::binary);
+    if (!(*data)) {
         egsWarning("VHP_OrganData: failed to open file %s for reading\n",
                    fname);
         return;
     }
     char endian;
-    data.read(&endian,sizeof(endian));
+    data->read(&endian,sizeof(endian));
     char my_endian = egsGetEndian();
     if (endian != my_endian) {
         egsWarning("VHP_OrganData: wrong endianess. \n"
@@ -89,10 +91,10 @@ VHP_OrganData::VHP_OrganData(const char *fname, int slice_min, int slice_max)
                    (int)my_endian,(int)endian);
         return;
     }
-    data.read((char *)&dx, sizeof(dx));
-    data.read((char *)&dy, sizeof(dy));
-    data.read((char *)&dz, sizeof(dz));
-    data.read((char *)&nslice,sizeof(nslice));
+    data->read((char *)&dx, sizeof(dx));
+    data->read((char *)&dy, sizeof(dy));
+    data->read((char *)&dz, sizeof(dz));
+    data->read((char *)&nslice,sizeof(nslice));
     if (slice_min < 0) {
         slice_min = 0;
     }
@@ -101,13 +103,27 @@ VHP_OrganData::VHP_OrganData(const char *fname, int slice_min, int slice_max)
     }
     int nwant = slice_max - slice_min;
     slices = new VHP_SliceInfo [nwant];
+    if (max_loaded > 0) {
+        offsets = new streamoff [nwant];
+        loaded = new char [nwant];
+        last_use = new EGS_I64 [nwant];
+    }
     nx = 0, ny = 0;
     int is = 0;
     for (int islice=0; islice<nslice; ++islice) {
         if (islice >= slice_min) {
-            slices[is].readData(data);
             int ni, nj;
-            slices[is++].getSliceDimensions(ni,nj);
+            if (max_loaded > 0) {
+                // only remember where the slice is, it is read when needed
+                offsets[is] = data->tellg();
+                loaded[is] = 0;
+                last_use[is++] = 0;
+                VHP_SliceInfo::skipData(*data,ni,nj);
+            }
+            else {
+                slices[is].readData(*data);
+                slices[is++].getSliceDimensions(ni,nj);
+            }
             if (ni > nx) {
                 nx = ni;
             }
@@ -116,8 +132,8 @@ VHP_OrganData::VHP_OrganData(const char *fname, int slice_min, int slice_max)
             }
         }
         else {
-            VHP_SliceInfo tmp;
-            tmp.readData(data);
+            int ni, nj;
+            VHP_SliceInfo::skipData(*data,ni,nj);
         }
         if (islice == slice_max - 1) {
             break;
@@ -125,18 +141,76 @@ VHP_OrganData::VHP_OrganData(const char *fname, int slice_min, int slice_max)
     }
     nxy = nx*ny;
     nslice = slice_max - slice_min;
-    if (data.fail()) {
+    if (data->fail()) {
         egsWarning("VHP_OrganData: I/O error while reading data\n");
     }
     else {
         ok = true;
     }
+    if (max_loaded <= 0) {
+        delete data;
+        data = 0;
+    }
 }
 
 VHP_OrganData::~VHP_OrganData() {
     if (nslice) {
         delete [] slices;
     }
+    if (data) {
+        delete data;
+    }
+    if (offsets) {
+        delete [] offsets;
+        delete [] loaded;
+        delete [] last_use;
+    }
+}
+
+void VHP_OrganData::loadSlice(int islice) const {
+    if (nloaded >= max_loaded) {
+        int iold = -1;
+        for (int j=0; j<nslice; ++j) {
+            if (loaded[j] && (iold < 0 || last_use[j] < last_use[iold])) {
+                iold = j;
+            }
+        }
+        slices[iold].unload();
+        loaded[iold] = 0;
+        --nloaded;
+    }
+    data->clear();
+    data->seekg(offsets[islice]);
+    slices[islice].readData(*data);
+    if (data->fail()) {
+        egsFatal("VHP_OrganData: I/O error while reading slice %d\n",islice);
+    }
+    loaded[islice] = 1;
+    ++nloaded;
+}
+
+void VHP_SliceInfo::skipData(istream &in, int &nx, int &ny) {
+    unsigned short first, last;
+    in.read((char *)&first,sizeof(first));
+    in.read((char *)&last,sizeof(last));
+    ny = last+1;
+    nx = 0;
+    int nrow = last-first+1;
+    for (int j=0; j<nrow; ++j) {
+        unsigned short n;
+        in.read((char *)&n,sizeof(n));
+        if (n < 1) {
+            continue;
+        }
+        // we only need the last pixel index of the row
+        unsigned short plast;
+        in.seekg(n*sizeof(unsigned short),ios::cur);
+        in.read((char *)&plast,sizeof(plast));
+        in.seekg(n*sizeof(unsigned char),ios::cur);
+        if (plast > nx) {
+            nx = plast;
+        }
+    }
 }
 
 void VHP_RowInfo::readData(istream &in) {
@@ -180,9 +254,9 @@ void VHP_SliceInfo::readData(istream &in) {
 
 EGS_VHPGeometry::EGS_VHPGeometry(const char *phantom_file,
                                  const char *media_file, int slice_min, int slice_max,
-                                 const string &Name) :
+                                 const string &Name, int max_loaded) :
     EGS_BaseGeometry(Name), vg(0), micros(0), nmicro(0) {
-    organs = new VHP_OrganData(phantom_file,slice_min,slice_max);
+    organs = new VHP_OrganData(phantom_file,slice_min,slice_max,max_loaded);
     if (!organs->isOK()) {
         egsWarning("EGS_VHPGeometry: failed to construct organ data\n");
         delete organs;
@@ -418,6 +492,8 @@ void EGS_VHPGeometry::printInfo() const {
     if (isOK()) {
         egsInformation("  voxel sizes: %g %g %g\n",vg->dx,vg->dy,vg->dz);
         egsInformation("  phantom size: %d %d %d\n",vg->nx,vg->ny,vg->nz);
+        egsInformation("  organ data: %d of %d slices in memory, %d bytes\n",
+                       organs->nLoaded(),organs->nSlice(),organs->getSize());
     }
     else {
         egsInformation("  undefined VHP geometry\n");
@@ -731,11 +807,20 @@ extern "C" {
         }
         vector<int> srange;
         err1 = input->getInput("slice range",srange);
+        int max_loaded = 0;
+        err2 = input->getInput("maximum loaded slices",max_loaded);
+        if (!err2 && max_loaded < 1) {
+            egsWarning("createGeometry(EGS_VHPGeometry): 'maximum loaded "
+                       "slices' must be positive, loading all slices\n");
+            max_loaded = 0;
+        }
         EGS_VHPGeometry *result;
         if (!err1 && srange.size() == 2 && srange[1] > srange[0]) result =
-                new EGS_VHPGeometry(phantom.c_str(),media.c_str(),srange[0],srange[1]);
+                new EGS_VHPGeometry(phantom.c_str(),media.c_str(),srange[0],
+                                    srange[1],"",max_loaded);
         else {
-            result = new EGS_VHPGeometry(phantom.c_str(),media.c_str());
+            result = new EGS_VHPGeometry(phantom.c_str(),media.c_str(),0,
+                                         1000000,"",max_loaded);
         }
         if (!result->isOK()) {
             egsWarning("createGeometry(EGS_VHPGeometry): failed to construct "
@@ -81,6 +81,7 @@
 #include "egs_functions.h"
 
 #include <iostream>
+#include <fstream>
 #include <string>
 
 using namespace std;
@@ -170,25 +171,51 @@ struct EGS_VHP_LOCAL VHP_SliceInfo {
         return result;
     };
     void readData(istream &in);
+    /*! Skips the data of a slice in \a in, returning its dimensions. */
+    static void skipData(istream &in, int &nx, int &ny);
+    /*! Frees the row data, the slice must be read again before use. */
+    void unload() {
+        if (rinfo) {
+            delete [] rinfo;
+            rinfo = 0;
+        }
+    };
 };
 #endif
 
 #ifndef SKIP_DOXYGEN
 /*! \brief A local class needed for the VHP implementation
 
+ If \a max_loaded is positive, only the slice offsets in the data file
+ are determined at construction and the slices are read on demand, keeping
+ at most \a max_loaded slices in memory (least recently used slices are
+ discarded first).
+
  \internwarning
 */
 class EGS_VHP_LOCAL VHP_OrganData {
 public:
-    VHP_OrganData(const char *fname, int slice_min=0, int slice_max=1000000);
+    VHP_OrganData(const char *fname, int slice_min=0, int slice_max=1000000,
+                  int max_loaded=0);
     ~VHP_OrganData();
 
     int         nSlice() const {
         return nslice;
     };
     int         getOrgan(int islice, int i, int j) const {
-        return islice >= 0 && islice < nslice ?
-               slices[islice].getOrgan(i,j) : 0;
+        if (islice < 0 || islice >= nslice) {
+            return 0;
+        }
+        if (max_loaded > 0) {
+            if (!loaded[islice]) {
+                loadSlice(islice);
+            }
+            last_use[islice] = ++nuse;
+        }
+        return slices[islice].getOrgan(i,j);
+    };
+    int nLoaded() const {
+        return max_loaded > 0 ? nloaded : nslice;
     };
     const VHP_SliceInfo &getVHP_SliceInfo(int j) const {
         return slices[j];
@@ -202,6 +229,10 @@ public:
             for (int j=0; j<nslice; ++j) {
                 result += slices[j].getSize();
             }
+            if (max_loaded > 0) {
+                result += nslice*(sizeof(*offsets) + sizeof(*loaded) +
+                                  sizeof(*last_use));
+            }
         }
         return result;
     };
@@ -236,6 +267,17 @@ protected:
     unsigned short  nslice;
     int             nx, ny, nxy;
     bool            ok;
+
+    // on-demand loading
+    int             max_loaded; //!< max. slices in memory (0 = all)
+    mutable int     nloaded;    //!< number of slices currently in memory
+    mutable EGS_I64 nuse;       //!< access counter for the LRU policy
+    ifstream       *data;       //!< phantom data file kept open
+    streamoff      *offsets;    //!< file position of each slice
+    char           *loaded;     //!< 1 if the slice is in memory
+    EGS_I64        *last_use;   //!< value of nuse at last access
+
+    void loadSlice(int islice) const;
 };
 #endif
 
@@ -1228,7 +1270,16 @@ protected:
  * \endverbatim
  * In the above, the <code>slice range</code> input, which is optional,
  * can be used to select a given slice range instead of using the entire
- * phantom. The file <code>phantom_data_file</code> is a binary file
+ * phantom. For high resolution phantoms the optional input
+ * \verbatim
+ * maximum loaded slices = N
+ * \endverbatim
+ * can be used to limit the memory required for the organ data: only the
+ * position of each slice in the phantom data file is determined when the
+ * geometry is constructed, slices are read from the file when first
+ * accessed, and at most \c N slices are kept in memory (the slices that
+ * have not been used for the longest time are discarded first). The
+ * default is to load all slices at construction. The file <code>phantom_data_file</code> is a binary file
  * containing the definition of the phantom. The format of this file is as
  * follows:
  *   - one byte indicating the endianess of the machine where the data was
@@ -1306,7 +1357,8 @@ class EGS_VHP_EXPORT EGS_VHPGeometry : public EGS_BaseGeometry {
 public:
 
     EGS_VHPGeometry(const char *phantom_file, const char *media_file,
-                    int slice_min=0, int slice_max=1000000, const string &Name="");
+                    int slice_min=0, int slice_max=1000000, const string &Name="",
+                    int max_loaded=0);
 
     ~EGS_VHPGeometry();
 
@@ -214,6 +214,27 @@ protected:
 
     EGS_Float ptime; //!< Time index corresponding to particle
 
+    /*!
+     * \brief Interpolation data for the motion between two consecutive control points
+     */
+    struct EGS_MotionSegment {
+        EGS_Float t0;          //!< Time index at the start of the segment
+        EGS_Float dt;          //!< Length of the segment in time index
+        EGS_Float trnsl[3];    //!< Translation at the start of the segment
+        EGS_Float dtrnsl[3];   //!< Change of the translation over the segment
+        EGS_Float rot[3];      //!< Rotation angles (degrees) at the start of the segment
+        EGS_Float drot[3];     //!< Change of the rotation angles over the segment
+        bool fixed_rot;        //!< True if the rotation is constant over the segment
+        bool fixed;            //!< True if the shape does not move over the segment
+        EGS_RotationMatrix R;  //!< The rotation if \a fixed_rot is true
+    };
+
+    vector<EGS_Float> tsearch;          //!< Control point time indices minus epsilon, searched for the segment
+    vector<EGS_MotionSegment> segments; //!< Segment i interpolates between control points i and i+1
+    int nrot;                           //!< Number of rotation parameters (2 or 3)
+    EGS_AffineTransform tcur;           //!< The transformation of the current history
+    int cur_seg;                        //!< The segment of the current position if it has no motion, -1 otherwise
+
     /*!
      * \brief Get the next state of the dynamic shape
      * \param rndm Random number generator
@@ -237,12 +258,22 @@ protected:
     }
 
     /*!
-     * \brief Extract coordinates for the next dynamic shape position
+     * \brief Get the transformation of the dynamic shape at time index \a rand
+     *
+     * The segment containing \a rand is found by a binary search in the
+     * segment table built by buildSegments().
+     *
      * \param rand Random number for time sampling
-     * \param gipt EGS_ControlPoint structure to store the coordinates
+     * \param t The interpolated transformation
+     * \param iseg If not null, set to the index of the segment
      * \return 0 if successful, otherwise 1
      */
-    int getCoord(EGS_Float rand, EGS_ControlPoint &gipt);
+    int getCoord(EGS_Float rand, EGS_AffineTransform &t, int *iseg = 0) const;
+
+    /*!
+     * \brief Build the segment table from the (normalized) control points
+     */
+    void buildSegments();
 
     /*!
      * \brief Build the dynamic shape using input specifications
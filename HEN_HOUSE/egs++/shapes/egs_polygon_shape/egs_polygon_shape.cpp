@@ -63,6 +63,15 @@ EGS_TriangleShape::EGS_TriangleShape(const EGS_Float *points,
     A = 0.5*fabs(ax*by-ay*bx);
 }
 
+void EGS_PolygonShape::setTriangle(Triangle &t, const EGS_Float *points) {
+    t.xo = points[0];
+    t.yo = points[1];
+    t.ax = points[2] - t.xo;
+    t.ay = points[3] - t.yo;
+    t.bx = points[4] - t.xo;
+    t.by = points[5] - t.yo;
+}
+
 EGS_PolygonShape::EGS_PolygonShape(const vector<EGS_Float> &points,
                                    const string &Name, EGS_ObjectFactory *f) : EGS_SurfaceShape(Name,f) {
     int np = points.size();
@@ -88,7 +97,7 @@ EGS_PolygonShape::EGS_PolygonShape(const vector<EGS_Float> &points,
     }
     EGS_2DPolygon pol(p1);
     int ntr = 0;
-    triangle = new EGS_TriangleShape* [n-2];
+    triangle = new Triangle [n-2];
     np = n;
     EGS_Float p_tmp[6];
     while (np > 3) {
@@ -113,8 +122,7 @@ EGS_PolygonShape::EGS_PolygonShape(const vector<EGS_Float> &points,
                     }
                 }
                 if (is_ok) {
-                    EGS_TriangleShape *t = new EGS_TriangleShape(p_tmp);
-                    triangle[ntr++] = t;
+                    setTriangle(triangle[ntr++],p_tmp);
                     for (int j=i+1; j<np-1; j++) {
                         xc[j] = xc[j+1];
                         yc[j] = yc[j+1];
@@ -128,10 +136,11 @@ EGS_PolygonShape::EGS_PolygonShape(const vector<EGS_Float> &points,
         p_tmp[2*k] = xc[k];
         p_tmp[2*k+1] = yc[k];
     }
-    triangle[ntr++] = new EGS_TriangleShape(p_tmp);
+    setTriangle(triangle[ntr++],p_tmp);
     A = 0;
     for (int i=0; i<ntr; i++) {
-        yc[i] = triangle[i]->area();
+        const Triangle &t = triangle[i];
+        yc[i] = 0.5*fabs(t.ax*t.by-t.ay*t.bx);
         A += yc[i];
     }
     table = new EGS_AliasTable(ntr,xc,yc,0);
@@ -122,22 +122,32 @@ public:
                      EGS_ObjectFactory *f=0);
     ~EGS_PolygonShape() {
         if (n > 0) {
-            for (int j=0; j<n-2; j++) {
-                delete triangle[j];
-            }
             delete [] triangle;
             delete table;
         }
     };
     EGS_Vector getPoint(EGS_RandomGenerator *rndm) {
-        int j = table->sampleBin(rndm);
-        return triangle[j]->getPoint(rndm);
+        const Triangle &t = triangle[table->sampleBin(rndm)];
+        EGS_Float eta_a = sqrt(rndm->getUniform());
+        EGS_Float eta_b = eta_a*rndm->getUniform();
+        eta_a = 1 - eta_a;
+        return EGS_Vector(t.xo + t.ax*eta_a + t.bx*eta_b,
+                          t.yo + t.ay*eta_a + t.by*eta_b,
+                          0);
     };
 
 protected:
 
-    int  n;  // number of triangles
-    EGS_TriangleShape **triangle;
+    /*! \brief A triangle of the polygon, sampled as in EGS_TriangleShape */
+    struct Triangle {
+        EGS_Float xo, yo, ax, ay, bx, by;
+    };
+
+    /*! \brief Sets \a t from the 3 2D points \a points */
+    static void setTriangle(Triangle &t, const EGS_Float *points);
+
+    int  n;  // number of polygon points
+    Triangle          *triangle;
     EGS_AliasTable    *table;
 
 };
@@ -42,6 +42,54 @@
 #include <fstream>
 using namespace std;
 
+/* Reads the probabilities of n voxels from data in chunks and keeps the
+   voxels with a non-zero probability. The voxel indices are taken from vmap,
+   or are 0...n-1 if vmap is null. Returns false on a read error or an
+   invalid voxel index. */
+template <class T> static bool readProbabilities(istream &data, int n,
+        const int *vmap, int nreg, vector<int> &voxels, vector<EGS_Float> &p) {
+    const int nchunk = 65536;
+    T *buf = new T [nchunk];
+    bool ok = true;
+    for (int i=0; i<n && ok; i+=nchunk) {
+        int m = n - i < nchunk ? n - i : nchunk;
+        data.read((char *)buf, m*sizeof(T));
+        if (data.fail()) {
+            ok = false;
+            break;
+        }
+        for (int k=0; k<m; ++k) {
+            if (buf[k] > 0) {
+                int voxel = vmap ? vmap[i+k] : i+k;
+                if (voxel < 0 || voxel >= nreg) {
+                    ok = false;
+                    break;
+                }
+                voxels.push_back(voxel);
+                p.push_back(buf[k]);
+            }
+        }
+    }
+    delete [] buf;
+    return ok;
+}
+
+bool EGS_VoxelizedShape::makeTable(const vector<int> &voxels,
+                                   const vector<EGS_Float> &p) {
+    int nmap = voxels.size();
+    if (nmap < 1) {
+        return false;
+    }
+    egsInformation("Making alias table for %d voxels with non-zero "
+                   "probability\n",nmap);
+    map = new int [nmap];
+    for (int j=0; j<nmap; ++j) {
+        map[j] = voxels[j];
+    }
+    prob = new EGS_SimpleAliasTable(nmap,&p[0]);
+    return true;
+}
+
 void EGS_VoxelizedShape::EGS_VoxelizedShapeFormat0(const char *fname,
         const string &Name,EGS_ObjectFactory *f) {
     prob=0;
@@ -111,24 +159,21 @@ void EGS_VoxelizedShape::EGS_VoxelizedShapeFormat0(const char *fname,
         delete [] z;
         return;
     }
-    int nmap;
-    float *p;
+    vector<int> voxels;
+    vector<EGS_Float> p;
     if (form == 0) {
-        p = new float [nreg];
         egsInformation("Format 0, reading %d values\n",nreg);
-        data.read((char *)p, nreg*sizeof(float));
-        if (data.fail()) {
+        if (!readProbabilities<float>(data,nreg,0,nreg,voxels,p)) {
             egsWarning("%s: failed to read probabilities\n",func);
-            delete [] p;
             delete [] x;
             delete [] y;
             delete [] z;
             return;
         }
-        nmap = nreg;
     }
     else {
         egsInformation("Format 1, reading data\n");
+        int nmap;
         data.read((char *)&nmap, sizeof(int));
         if (data.fail() || nmap < 1) {
             egsWarning("%s: failed to read nmap\n",func);
@@ -137,28 +182,28 @@ void EGS_VoxelizedShape::EGS_VoxelizedShapeFormat0(const char *fname,
             delete [] z;
             return;
         }
-        map = new int [nmap];
-        p = new float [nmap];
-        data.read((char *)map, nmap*sizeof(int));
-        data.read((char *)p, nmap*sizeof(float));
-        if (data.fail()) {
+        int *vmap = new int [nmap];
+        data.read((char *)vmap, nmap*sizeof(int));
+        bool ok = !data.fail() &&
+                  readProbabilities<float>(data,nmap,vmap,nreg,voxels,p);
+        delete [] vmap;
+        if (!ok) {
             egsWarning("%s: failed to read probabilities and bin numbers\n",func);
-            delete [] p;
-            delete [] map;
             delete [] x;
             delete [] y;
             delete [] z;
             return;
         }
     }
-    EGS_Float *p1 = new EGS_Float [nmap];
-    int j;
-    for (j=0; j<nmap; ++j) {
-        p1[j] = p[j];
+    if (!makeTable(voxels,p)) {
+        egsWarning("%s: no voxel with a non-zero probability in %s\n",
+                   func,fname);
+        delete [] x;
+        delete [] y;
+        delete [] z;
+        return;
     }
-    delete [] p;
-    egsInformation("Making alias table\n");
-    prob = new EGS_SimpleAliasTable(nmap,p1);
+    int j;
     xpos = new EGS_Float [nx+1];
     ypos = new EGS_Float [ny+1];
     zpos = new EGS_Float [nz+1];
@@ -305,35 +350,35 @@ EGS_VoxelizedShape::EGS_VoxelizedShape(int file_format, const char *fname,
                    "%s\n",func,data_file.c_str());
         return;
     }
-    int nmap = nreg;
-    float *p = new float [nreg];
+    vector<int> voxels;
+    vector<EGS_Float> p;
+    bool ok;
     if (data_type == 0) {
-        i_file.read((char *)p, nreg*sizeof(float));
+        ok = readProbabilities<float>(i_file,nreg,0,nreg,voxels,p);
     }
     else if (data_type == 1) {
-        unsigned short int *p_tmp = new unsigned short int [nreg];
-        i_file.read((char *)p_tmp, nreg*sizeof(unsigned short int));
-        for (int cc = 0; cc<nreg; cc++) {
-            p[cc] = (float)(p_tmp[cc]);
-        }
-        delete [] p_tmp;
+        ok = readProbabilities<unsigned short int>(i_file,nreg,0,nreg,voxels,p);
     }
     else {
-        short int *p_tmp = new short int [nreg];
-        i_file.read((char *)p_tmp, nreg*sizeof(short int));
-        for (int cc = 0; cc<nreg; cc++) {
-            p[cc] = (float)(p_tmp[cc]);
-        }
-        delete [] p_tmp;
+        ok = readProbabilities<short int>(i_file,nreg,0,nreg,voxels,p);
     }
-    EGS_Float *p1 = new EGS_Float [nmap];
-    int j;
-    for (j=0; j<nmap; ++j) {
-        p1[j] = p[j];
+    if (!ok) {
+        egsWarning("%s: failed to read interfile data %s\n",func,
+                   data_file.c_str());
+        delete [] x;
+        delete [] y;
+        delete [] z;
+        return;
+    }
+    if (!makeTable(voxels,p)) {
+        egsWarning("%s: no voxel with a non-zero probability in %s\n",func,
+                   data_file.c_str());
+        delete [] x;
+        delete [] y;
+        delete [] z;
+        return;
     }
-    delete [] p;
-    egsInformation("Making alias table\n");
-    prob = new EGS_SimpleAliasTable(nmap,p1);
+    int j;
     xpos = new EGS_Float [nx+1];
     ypos = new EGS_Float [ny+1];
     zpos = new EGS_Float [nz+1];
@@ -360,9 +405,7 @@ EGS_VoxelizedShape::~EGS_VoxelizedShape() {
         delete [] xpos;
         delete [] ypos;
         delete [] zpos;
-        if (type == 1) {
-            delete [] map;
-        }
+        delete [] map;
     }
 }
 
@@ -93,6 +93,12 @@ The \c some_file file must be a binary file containing the following information
    the integer define voxe indeces and the floats the corresponding probabilities.
    This format is useful when the number of non-zero probability voxels is small
    compared to the total number of voxels.
+
+Voxels with zero probability are dropped when the file is read, so that the
+alias table used for picking voxels only holds the voxels that can be
+selected, whatever the file format. The probabilities are read in chunks,
+so that large activity maps (\em e.g. 256x256x256 voxels derived from
+SPECT or PET images) never need a full copy of the file in memory.
 */
 class EGS_VOXELIZED_SHAPE_EXPORT EGS_VoxelizedShape : public EGS_BaseShape {
 
@@ -109,8 +115,7 @@ public:
     void EGS_VoxelizedShapeFormat0(const char *fname,const string &Name="",
                                    EGS_ObjectFactory *f=0);
     EGS_Vector getPoint(EGS_RandomGenerator *rndm) {
-        int bin = prob->sample(rndm);
-        int voxel = type == 0 ? bin : map[bin];
+        int voxel = map[prob->sample(rndm)];
         int iz = voxel/nxy;
         voxel -= iz*nxy;
         int iy = voxel/nx;
@@ -129,11 +134,16 @@ public:
 
 protected:
 
+    /*! \brief Makes the alias table and voxel map from the non-zero
+      probabilities \a p of the voxels \a voxels. Returns false if there
+      are no such voxels. */
+    bool makeTable(const vector<int> &voxels, const vector<EGS_Float> &p);
+
     EGS_SimpleAliasTable *prob;   ///! The alias table for randomly picking voxels
     EGS_Float  *xpos;             ///! The x-positions of the grid
     EGS_Float  *ypos;             ///! The y-positions of the grid
     EGS_Float  *zpos;             ///! The z-positions of the grid
-    int        *map;              ///! Voxel map (for type=1)
+    int        *map;              ///! Voxel index of each alias table bin
     int        nx, ny, nz, nxy, nreg;
     int        type;
 };
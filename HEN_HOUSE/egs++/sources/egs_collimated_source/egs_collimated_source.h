@@ -206,6 +206,14 @@ public:
         ctry += ntry;
     };
 
+    /*! \brief Sample the next \a n particles without a virtual function
+      call per particle (see EGS_BaseSource::getNextParticles()). */
+    EGS_I64 getNextParticles(EGS_RandomGenerator *rndm, int n,
+                             int *Q, int *latch, EGS_Float *E, EGS_Float *wt,
+                             EGS_Vector *x, EGS_Vector *u, EGS_I64 *icase = 0) {
+        return sampleParticles(this,rndm,n,Q,latch,E,wt,x,u,icase);
+    };
+
     EGS_Float getFluence() const {
         double res = ctry;
         return res/(dist*dist);
@@ -37,6 +37,8 @@
 #include "egs_dynamic_source.h"
 #include "egs_input.h"
 
+#include <algorithm>
+
 EGS_DynamicSource::EGS_DynamicSource(EGS_Input *input,
                                      EGS_ObjectFactory *f) : EGS_BaseSource(input,f), source(0), valid(true) {
     EGS_Input *isource = input->takeInputItem("source",false);
@@ -155,6 +157,7 @@ EGS_DynamicSource::EGS_DynamicSource(EGS_Input *input,
 void EGS_DynamicSource::setUp() {
     //most setup done in constructor
     otype="EGS_DynamicSource";
+    buildSegments();
     if (!isValid()) {
         description = "Invalid dynamic source";
     }
@@ -167,28 +170,61 @@ void EGS_DynamicSource::setUp() {
     }
 }
 
-//actually select the rotation coordinates for the incident particle
-int EGS_DynamicSource::getCoord(EGS_Float rand, EGS_ControlPoint &ipt) {
-    int iindex=0;
-    int i;
-    for (i=0; i<ncpts; i++) {
-        if (rand < cpts[i].time-epsilon) {
-            iindex =i;
-            break;
+void EGS_DynamicSource::buildSegments() {
+    //differences between consecutive control points are computed once
+    //here instead of for every particle
+    int npts = cpts.size();
+    tsearch.resize(npts);
+    segments.resize(npts > 1 ? npts-1 : 0);
+    for (int i=0; i<npts; i++) {
+        tsearch[i] = cpts[i].time-epsilon;
+    }
+    for (int i=0; i<npts-1; i++) {
+        const EGS_ControlPoint &c0 = cpts[i], &c1 = cpts[i+1];
+        EGS_MotionSegment &s = segments[i];
+        s.t0 = c0.time;
+        s.dt = c1.time-c0.time;
+        s.p = c0;
+        s.dp.iso = c1.iso-c0.iso;
+        s.dp.dsource = c1.dsource-c0.dsource;
+        s.dp.theta = c1.theta-c0.theta;
+        s.dp.phi = c1.phi-c0.phi;
+        s.dp.phicol = c1.phicol-c0.phicol;
+        s.dp.time = s.dt;
+        //the rotation of segments with constant angles (e.g. step and
+        //shoot) is precomputed
+        s.fixed_rot = s.dp.theta == 0 && s.dp.phi == 0 && s.dp.phicol == 0;
+        if (s.fixed_rot) {
+            s.R = getRotation(c0.theta,c0.phi,c0.phicol);
         }
     }
-    if (i==ncpts) {
+}
+
+//actually select the rotation coordinates for the incident particle
+int EGS_DynamicSource::getCoord(EGS_Float rand, EGS_Vector &iso,
+                                EGS_Float &dsource,
+                                EGS_RotationMatrix &R) const {
+    //first control point with a time index larger than rand
+    int iindex = upper_bound(tsearch.begin(),tsearch.end(),rand) -
+                 tsearch.begin();
+    if (iindex == 0 || iindex == (int)tsearch.size()) {
         egsWarning("EGS_DynamicSource: could not locate control point.\n");
         return 1;
     }
-    EGS_Float factor = (rand-cpts[iindex-1].time)/(cpts[iindex].time-cpts[iindex-1].time);
-    ipt.iso.x=cpts[iindex-1].iso.x+ (cpts[iindex].iso.x-cpts[iindex-1].iso.x)*factor;
-    ipt.iso.y=cpts[iindex-1].iso.y+ (cpts[iindex].iso.y-cpts[iindex-1].iso.y)*factor;
-    ipt.iso.z=cpts[iindex-1].iso.z+ (cpts[iindex].iso.z-cpts[iindex-1].iso.z)*factor;
-    ipt.dsource=cpts[iindex-1].dsource+ (cpts[iindex].dsource-cpts[iindex-1].dsource)*factor;
-    ipt.theta=cpts[iindex-1].theta+ (cpts[iindex].theta-cpts[iindex-1].theta)*factor;
-    ipt.phi=cpts[iindex-1].phi+ (cpts[iindex].phi-cpts[iindex-1].phi)*factor;
-    ipt.phicol=cpts[iindex-1].phicol+ (cpts[iindex].phicol-cpts[iindex-1].phicol)*factor;
+    const EGS_MotionSegment &s = segments[iindex-1];
+    EGS_Float factor = (rand-s.t0)/s.dt;
+    iso.x = s.p.iso.x + s.dp.iso.x*factor;
+    iso.y = s.p.iso.y + s.dp.iso.y*factor;
+    iso.z = s.p.iso.z + s.dp.iso.z*factor;
+    dsource = s.p.dsource + s.dp.dsource*factor;
+    if (s.fixed_rot) {
+        R = s.R;
+    }
+    else {
+        R = getRotation(s.p.theta + s.dp.theta*factor,
+                        s.p.phi + s.dp.phi*factor,
+                        s.p.phicol + s.dp.phicol*factor);
+    }
     return 0;
 };
 
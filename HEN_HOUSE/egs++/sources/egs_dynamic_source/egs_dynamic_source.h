@@ -226,7 +226,9 @@ public:
                             int &q, int &latch, EGS_Float &E, EGS_Float &wt,
                             EGS_Vector &x, EGS_Vector &u) {
         int err = 1;
-        EGS_ControlPoint ipt;
+        EGS_Vector iso;
+        EGS_Float dsource;
+        EGS_RotationMatrix R;
         EGS_I64 c;
         while (err) {
             c = source->getNextParticle(rndm,q,latch,E,wt,x,u);
@@ -242,22 +244,14 @@ public:
                 ptime = rndm->getUniform();
             }
             setTimeIndex(ptime); //this is added for the storing of time index in a single location. Technically stored as a basesource attribute not dynamic source
-            err = getCoord(ptime,ipt);
+            err = getCoord(ptime,iso,dsource,R);
         }
 
         //translate source in Z
-        x.z=x.z-ipt.dsource;
-        //get the rotation matrices
-        ipt.phicol *= M_PI/180;
-        ipt.theta *= M_PI/180;
-        ipt.phi *= M_PI/180;
-        EGS_RotationMatrix Rcol(EGS_RotationMatrix::rotZ(ipt.phicol));
-        EGS_RotationMatrix Rtheta(EGS_RotationMatrix::rotY(ipt.theta));
-        EGS_RotationMatrix Rphi(EGS_RotationMatrix::rotZ(ipt.phi));
-        //apply rotations in specific order and then translate relative
-        //to the isocentre
-        u=Rphi*Rtheta*Rcol*u;
-        x=Rphi*Rtheta*Rcol*x + ipt.iso;
+        x.z=x.z-dsource;
+        //apply the rotation and then translate relative to the isocentre
+        u=R*u;
+        x=R*x + iso;
         return c;
     };
     EGS_Float getEmax() const {
@@ -302,7 +296,40 @@ protected:
     bool sync; //set to true if source motion synched with time read from
     //iaea phsp or beam simulation source
 
-    int getCoord(const EGS_Float rand, EGS_ControlPoint &ipt);
+    /*! \brief Interpolation data for the motion between two consecutive
+      control points.
+    */
+    struct EGS_MotionSegment {
+        EGS_Float t0, dt;   //start time index and length of the segment
+        EGS_ControlPoint p; //coordinates at the start of the segment
+        EGS_ControlPoint dp;//change of the coordinates over the segment
+        bool fixed_rot;     //true if the angles are constant over the segment
+        EGS_RotationMatrix R; //the rotation if fixed_rot is true
+    };
+
+    vector<EGS_Float> tsearch;  //control point time indices minus epsilon
+    vector<EGS_MotionSegment> segments; //segment i is between cpts i and i+1
+
+    /*! \brief Builds the segment table from the (normalized) control points */
+    void buildSegments();
+
+    /*! \brief Gets the isocentre, source distance and rotation at time index
+      \a rand, using a binary search for the segment containing \a rand.
+      Returns 0 on success and 1 if \a rand is outside of the control points.
+    */
+    int getCoord(const EGS_Float rand, EGS_Vector &iso, EGS_Float &dsource,
+                 EGS_RotationMatrix &R) const;
+
+    /*! \brief The rotation for the angles \a theta, \a phi and \a phicol
+      in degrees.
+    */
+    static EGS_RotationMatrix getRotation(EGS_Float theta, EGS_Float phi,
+                                          EGS_Float phicol) {
+        EGS_RotationMatrix Rcol(EGS_RotationMatrix::rotZ(phicol*(M_PI/180)));
+        EGS_RotationMatrix Rtheta(EGS_RotationMatrix::rotY(theta*(M_PI/180)));
+        EGS_RotationMatrix Rphi(EGS_RotationMatrix::rotZ(phi*(M_PI/180)));
+        return Rphi*Rtheta*Rcol;
+    };
 
     EGS_Float ptime; //time index corresponding to particle
     //could just be a random number.
@@ -264,6 +264,21 @@ EGS_RadionuclideSpectrum *EGS_RadionuclideSource::createSpectrum(EGS_Input *inpu
         outputBetaSpectra = "no";
     }
 
+    // Determine whether to cache the beta energy spectra in the application
+    // directory for reuse by later runs (options: yes or no)
+    string tmp_cacheBetaSpectra;
+    bool cacheBetaSpectra = false;
+    err = inp->getInput("cache beta spectra", tmp_cacheBetaSpectra);
+    if (!err) {
+        if (inp->compare(tmp_cacheBetaSpectra,"yes")) {
+            cacheBetaSpectra = true;
+            egsInformation("EGS_RadionuclideSource::createSpectrum: Beta energy spectra will be cached in the application directory.\n");
+        }
+        else if (!inp->compare(tmp_cacheBetaSpectra,"no")) {
+            egsFatal("EGS_RadionuclideSource::createSpectrum: Error: Invalid selection for 'cache beta spectra'. Use 'no' (default) or 'yes'.\n");
+        }
+    }
+
     // Determine whether to score alpha energy locally or discard it
     // By default, the energy is discarded
     string tmp_alphaScoring;
@@ -345,7 +360,7 @@ EGS_RadionuclideSpectrum *EGS_RadionuclideSource::createSpectrum(EGS_Input *inpu
     ensdf_fh.close();
 
     // Create the spectrum
-    EGS_RadionuclideSpectrum *spec = new EGS_RadionuclideSpectrum(nuclide, ensdf_file, relativeActivity, relaxType, outputBetaSpectra, scoreAlphasLocally, allowMultiTransition);
+    EGS_RadionuclideSpectrum *spec = new EGS_RadionuclideSpectrum(nuclide, ensdf_file, relativeActivity, relaxType, outputBetaSpectra, scoreAlphasLocally, allowMultiTransition, cacheBetaSpectra);
 
     return spec;
 }
@@ -537,7 +552,7 @@ extern "C" {
 }
 
 EGS_RadionuclideSpectrum::EGS_RadionuclideSpectrum(const string nuclide, const string ensdf_file,
-        const EGS_Float relativeActivity, const string relaxType, const string outputBetaSpectra, const bool scoreAlphasLocally, const bool allowMultiTransition) {
+        const EGS_Float relativeActivity, const string relaxType, const string outputBetaSpectra, const bool scoreAlphasLocally, const bool allowMultiTransition, const bool cacheBetaSpectra) {
 
     // For now, hard-code verbose mode
     // 0 - minimal output
@@ -553,7 +568,7 @@ EGS_RadionuclideSpectrum::EGS_RadionuclideSpectrum(const string nuclide, const s
     decays->normalizeIntensities();
 
     // Get the beta energy spectra
-    betaSpectra = new EGS_RadionuclideBetaSpectrum(decays, outputBetaSpectra);
+    betaSpectra = new EGS_RadionuclideBetaSpectrum(decays, outputBetaSpectra, cacheBetaSpectra);
 
     // Get the particle records from the decay scheme
     myBetas = decays->getBetaRecords();
@@ -568,12 +583,13 @@ EGS_RadionuclideSpectrum::EGS_RadionuclideSpectrum(const string nuclide, const s
     augerEnergies = decays->getAugerEnergies();
 
     // Initialization
-    currentLevel = 0;
+    currentLevel = -1;
     Emax = 0;
     currentTime = 0;
     ishower = -1; // Start with ishower -1 so first shower has index 0
     totalGammaEnergy = 0;
     relaxationType = relaxType;
+    eadlRelaxations = (relaxType == "eadl");
     scoreAlphasLocal = scoreAlphasLocally;
 
     // Get the maximum energy for emissions
@@ -622,6 +638,11 @@ EGS_RadionuclideSpectrum::EGS_RadionuclideSpectrum(const string nuclide, const s
         }
     }
 
+    // Flatten the level transitions and the disintegration records into
+    // contiguous sampling tables
+    buildLevelTables();
+    buildBranchTable();
+
     // Set the weight of the spectrum
     spectrumWeight = relativeActivity;
 
@@ -635,6 +656,173 @@ EGS_RadionuclideSpectrum::EGS_RadionuclideSpectrum(const string nuclide, const s
 };
 
 
+int EGS_RadionuclideSpectrum::findLevel(const LevelRecord *level) const {
+    if (!level) {
+        return -1;
+    }
+    for (unsigned int j=0; j<levelRecords.size(); ++j) {
+        if (levelRecords[j] == level) {
+            return j;
+        }
+    }
+    return -1;
+}
+
+void EGS_RadionuclideSpectrum::addLevel(const LevelRecord *level) {
+    if (level && findLevel(level) < 0) {
+        levelRecords.push_back(level);
+    }
+}
+
+void EGS_RadionuclideSpectrum::buildLevelTables() {
+
+    // Collect the daughter levels, including any level only referenced
+    // by a record
+    for (unsigned int i=0; i<myLevels.size(); ++i) {
+        addLevel(myLevels[i]);
+    }
+    for (unsigned int i=0; i<myGammas.size(); ++i) {
+        addLevel(myGammas[i]->getLevelRecord());
+        addLevel(myGammas[i]->getFinalLevel());
+    }
+    for (unsigned int i=0; i<myBetas.size(); ++i) {
+        addLevel(myBetas[i]->getLevelRecord());
+    }
+    for (unsigned int i=0; i<myAlphas.size(); ++i) {
+        addLevel(myAlphas[i]->getLevelRecord());
+    }
+    for (unsigned int i=0; i<myMetastableGammas.size(); ++i) {
+        addLevel(myMetastableGammas[i]->getLevelRecord());
+    }
+
+    nlevel = levelRecords.size();
+    levelActive = new bool [nlevel];
+    levelHalfLife = new double [nlevel];
+    levelFirst = new int [nlevel+1];
+    for (int l=0; l<nlevel; ++l) {
+        levelActive[l] = levelRecords[l]->levelCanDecay() &&
+                         levelRecords[l]->getEnergy() > epsilon;
+        levelHalfLife[l] = levelRecords[l]->getHalfLife();
+        levelFirst[l] = 0;
+    }
+    levelFirst[nlevel] = 0;
+
+    // Sort the gamma transitions by initial level, keeping the order of
+    // the gamma records within each level (the transition intensities are
+    // cumulative in that order)
+    int *glevel = new int [myGammas.size()+1];
+    for (unsigned int i=0; i<myGammas.size(); ++i) {
+        glevel[i] = findLevel(myGammas[i]->getLevelRecord());
+        if (glevel[i] >= 0) {
+            levelFirst[glevel[i]+1]++;
+        }
+    }
+    for (int l=0; l<nlevel; ++l) {
+        levelFirst[l+1] += levelFirst[l];
+    }
+    ntrans = levelFirst[nlevel];
+    transGamma = new GammaRecord* [ntrans+1];
+    transIntensity = new double [ntrans+1];
+    transFinal = new int [ntrans+1];
+    int *next = new int [nlevel+1];
+    for (int l=0; l<nlevel; ++l) {
+        next[l] = levelFirst[l];
+    }
+    for (unsigned int i=0; i<myGammas.size(); ++i) {
+        if (glevel[i] < 0) {
+            continue;
+        }
+        int k = next[glevel[i]]++;
+        transGamma[k] = myGammas[i];
+        transIntensity[k] = myGammas[i]->getTransitionIntensity();
+        transFinal[k] = findLevel(myGammas[i]->getFinalLevel());
+    }
+    delete [] next;
+    delete [] glevel;
+}
+
+void EGS_RadionuclideSpectrum::buildBranchTable() {
+
+    // The normalized intensities are cumulative over the records in the
+    // order betas, alphas, metastable gammas, uncorrelated gammas, x-rays
+    // and Auger electrons, and a decay used to be sampled by walking the
+    // records until the uniform random number fell below the cumulative
+    // intensity. The probability of each branch is therefore the increase
+    // of the running maximum of the cumulative intensities (capped at 1),
+    // and the remainder up to 1 is counted as fission.
+    vector<double> cum;
+    vector<int> type, index;
+    for (unsigned int i=0; i<myBetas.size(); ++i) {
+        cum.push_back(myBetas[i]->getBetaIntensity());
+        type.push_back(BetaBranch);
+        index.push_back(i);
+    }
+    for (unsigned int i=0; i<myAlphas.size(); ++i) {
+        cum.push_back(myAlphas[i]->getAlphaIntensity());
+        type.push_back(AlphaBranch);
+        index.push_back(i);
+    }
+    for (unsigned int i=0; i<myMetastableGammas.size(); ++i) {
+        cum.push_back(myMetastableGammas[i]->getTransitionIntensity());
+        type.push_back(MetastableBranch);
+        index.push_back(i);
+    }
+    for (unsigned int i=0; i<myUncorrelatedGammas.size(); ++i) {
+        cum.push_back(myUncorrelatedGammas[i]->getTransitionIntensity());
+        type.push_back(UncorrelatedBranch);
+        index.push_back(i);
+    }
+    for (unsigned int i=0; i<xrayIntensities.size(); ++i) {
+        cum.push_back(xrayIntensities[i]);
+        type.push_back(XRayBranch);
+        index.push_back(i);
+    }
+    for (unsigned int i=0; i<augerIntensities.size(); ++i) {
+        cum.push_back(augerIntensities[i]);
+        type.push_back(AugerBranch);
+        index.push_back(i);
+    }
+
+    vector<EGS_Float> prob;
+    vector<int> btype, bindex;
+    double last = 0;
+    for (unsigned int j=0; j<cum.size(); ++j) {
+        double c = cum[j] < 1 ? cum[j] : 1;
+        if (c > last) {
+            prob.push_back(c - last);
+            btype.push_back(type[j]);
+            bindex.push_back(index[j]);
+            last = c;
+        }
+    }
+    if (last < 1) {
+        prob.push_back(1 - last);
+        btype.push_back(FissionBranch);
+        bindex.push_back(0);
+    }
+
+    nbranch = prob.size();
+    branchType = new int [nbranch];
+    branchIndex = new int [nbranch];
+    branchLevel = new int [nbranch];
+    for (int j=0; j<nbranch; ++j) {
+        branchType[j] = btype[j];
+        branchIndex[j] = bindex[j];
+        const LevelRecord *level = 0;
+        if (btype[j] == BetaBranch) {
+            level = myBetas[bindex[j]]->getLevelRecord();
+        }
+        else if (btype[j] == AlphaBranch) {
+            level = myAlphas[bindex[j]]->getLevelRecord();
+        }
+        else if (btype[j] == MetastableBranch) {
+            level = myMetastableGammas[bindex[j]]->getLevelRecord();
+        }
+        branchLevel[j] = findLevel(level);
+    }
+    branchTable = new EGS_SimpleAliasTable(nbranch,&prob[0]);
+}
+
 void EGS_RadionuclideSpectrum::printSampledEmissions() {
 
     egsInformation("\nSampled %s emissions:\n", decays->radionuclide.c_str());
@@ -747,109 +935,107 @@ EGS_Float EGS_RadionuclideSpectrum::sample(EGS_RandomGenerator *rndm) {
 
     // If the daughter is in an excited state
     // check for transitions
-    if (currentLevel && currentLevel->levelCanDecay() && currentLevel->getEnergy() > epsilon) {
-
-        for (vector<GammaRecord *>::iterator gamma = myGammas.begin();
-                gamma != myGammas.end(); gamma++) {
+    if (currentLevel >= 0 && levelActive[currentLevel]) {
 
-            if ((*gamma)->getLevelRecord() == currentLevel) {
+        // The transitions from this level are stored contiguously, in the
+        // order of the gamma records
+        for (int k=levelFirst[currentLevel]; k<levelFirst[currentLevel+1]; ++k) {
 
-                if (u < (*gamma)->getTransitionIntensity()) {
+            if (u < transIntensity[k]) {
 
-                    // A gamma transition may either be a gamma emission
-                    // or an internal conversion electron
-                    EGS_Float u2 = 0;
-                    if ((*gamma)->getGammaIntensity() < 1) {
-                        u2 = rndm->getUniform();
-                    }
+                GammaRecord *gamma = transGamma[k];
 
-                    // Sample how long
-                    // it took for this transition to occur
-                    // time = -halflife / ln(2) * log(1-u)
-                    double hl = currentLevel->getHalfLife();
-                    if (hl > 0) {
-                        currentTime = -hl * log(1.-rndm->getUniform()) /
-                                      0.693147180559945309417232121458176568075500134360255254120680009493393;
-                    }
-
-                    // Determine whether multiple gamma transitions occur
-                    if (rndm->getUniform() < (*gamma)->getMultiTransitionProb()) {
-                        multiTransitions.push_back(currentLevel);
-                    }
+                // A gamma transition may either be a gamma emission
+                // or an internal conversion electron
+                EGS_Float u2 = 0;
+                if (gamma->getGammaIntensity() < 1) {
+                    u2 = rndm->getUniform();
+                }
 
-                    // Update the level of the daughter
-                    currentLevel = (*gamma)->getFinalLevel();
+                // Sample how long
+                // it took for this transition to occur
+                // time = -halflife / ln(2) * log(1-u)
+                double hl = levelHalfLife[currentLevel];
+                if (hl > 0) {
+                    currentTime = -hl * log(1.-rndm->getUniform()) /
+                                  0.693147180559945309417232121458176568075500134360255254120680009493393;
+                }
 
-                    // If a gamma emission occurs
-                    if (u2 < (*gamma)->getGammaIntensity()) {
+                // Determine whether multiple gamma transitions occur
+                if (rndm->getUniform() < gamma->getMultiTransitionProb()) {
+                    multiTransitions.push_back(currentLevel);
+                }
 
-                        (*gamma)->incrGammaSampled();
+                // Update the level of the daughter
+                currentLevel = transFinal[k];
 
-                        currentQ = (*gamma)->getCharge();
+                // If a gamma emission occurs
+                if (u2 < gamma->getGammaIntensity()) {
 
-                        E = (*gamma)->getDecayEnergy();
+                    gamma->incrGammaSampled();
 
-                        totalGammaEnergy += E;
+                    currentQ = gamma->getCharge();
 
-                        emissionType = 2;
+                    E = gamma->getDecayEnergy();
 
-                        return E;
+                    totalGammaEnergy += E;
 
-                    }
-                    else if (u2 < (*gamma)->getICIntensity()) {
-                        (*gamma)->incrICSampled();
-                        currentQ = -1;
-                        emissionType = 3;
+                    emissionType = 2;
 
-                        if ((*gamma)->icIntensity.size()) {
+                    return E;
 
-                            // Determine which shell the conversion electron
-                            // comes from. This will create a shell vacancy
-                            EGS_Float u3 = rndm->getUniform();
+                }
+                else if (u2 < gamma->getICIntensity()) {
+                    gamma->incrICSampled();
+                    currentQ = -1;
+                    emissionType = 3;
 
-                            for (unsigned int i=0; i<(*gamma)->icIntensity.size(); ++i) {
-                                if (u3 < (*gamma)->icIntensity[i]) {
+                    if (gamma->icIntensity.size()) {
 
-                                    E = (*gamma)->getDecayEnergy() - (*gamma)->getBindingEnergy(i);
+                        // Determine which shell the conversion electron
+                        // comes from. This will create a shell vacancy
+                        EGS_Float u3 = rndm->getUniform();
 
-                                    //                                     egsInformation("test %d %f %f %f\n",i,(*gamma)->getDecayEnergy(),decays->getRelaxations()->getBindingEnergy(decays->Z,i),E);
+                        for (unsigned int i=0; i<gamma->icIntensity.size(); ++i) {
+                            if (u3 < gamma->icIntensity[i]) {
 
-                                    // Add relaxation particles to the source stack
-                                    if (relaxationType == "eadl") {
+                                E = gamma->getDecayEnergy() - gamma->getBindingEnergy(i);
 
-                                        // Generate relaxation particles for a
-                                        // shell vacancy i
-                                        (*gamma)->relax(i,app->getEcut()-app->getRM(),app->getPcut(),rndm,edep,relaxParticles);
-                                    }
+                                // Add relaxation particles to the source stack
+                                if (eadlRelaxations) {
 
-                                    // Return the conversion electron
-                                    return E;
+                                    // Generate relaxation particles for a
+                                    // shell vacancy i
+                                    gamma->relax(i,app->getEcut()-app->getRM(),app->getPcut(),rndm,edep,relaxParticles);
                                 }
+
+                                // Return the conversion electron
+                                return E;
                             }
                         }
-                        return 0;
                     }
-                    else {
-                        (*gamma)->incrIPSampled();
-                        emissionType = 13;
+                    return 0;
+                }
+                else {
+                    gamma->incrIPSampled();
+                    emissionType = 13;
 
-                        // Internal pair production results in a positron
-                        // and electron pair
+                    // Internal pair production results in a positron
+                    // and electron pair
 
-                        //TODO: This is left for future work, we need to
-                        // determine the energies of the electron/positron
-                        // pair (sample uniformly?) and then determine the
-                        // corresponding directions. It might be best to do
-                        // this in the source instead of the spectrum.
+                    //TODO: This is left for future work, we need to
+                    // determine the energies of the electron/positron
+                    // pair (sample uniformly?) and then determine the
+                    // corresponding directions. It might be best to do
+                    // this in the source instead of the spectrum.
 
-                        currentQ = 1;
-                        return 0;
-                    }
+                    currentQ = 1;
+                    return 0;
                 }
             }
         }
 
-        currentLevel = 0;
+        currentLevel = -1;
         return 0;
     }
 
@@ -867,223 +1053,219 @@ EGS_Float EGS_RadionuclideSpectrum::sample(EGS_RandomGenerator *rndm) {
     // ============================
     currentTime = 0;
 
+    // The disintegration (or uncorrelated emission) is sampled from the
+    // flattened branch table using the same uniform random number
+    int ibranch = branchTable->sampleBin(u);
+    int i = branchIndex[ibranch];
+
+    switch (branchType[ibranch]) {
+
     // Beta-, beta+ and electron capture
-    for (vector<BetaRecordLeaf *>::iterator beta = myBetas.begin();
-            beta != myBetas.end(); beta++) {
-        if (u < (*beta)->getBetaIntensity()) {
+    case BetaBranch: {
+        BetaRecordLeaf *beta = myBetas[i];
 
-            // Increment the shower number
-            ishower++;
+        // Increment the shower number
+        ishower++;
 
-            // Increment the counter of betas and get the charge
-            (*beta)->incrNumSampled();
-            currentQ = (*beta)->getCharge();
+        // Increment the counter of betas and get the charge
+        beta->incrNumSampled();
+        currentQ = beta->getCharge();
 
-            // Set the energy level of the daughter
-            currentLevel = (*beta)->getLevelRecord();
+        // Set the energy level of the daughter
+        currentLevel = branchLevel[ibranch];
 
-            // For beta+ records we decide between
-            // branches for beta+ or electron capture
-            if (currentQ == 1) {
-                // For positron emission, continue as usual
-                if ((*beta)->getPositronIntensity() > epsilon && rndm->getUniform() < (*beta)->getPositronIntensity()) {
+        // For beta+ records we decide between
+        // branches for beta+ or electron capture
+        if (currentQ == 1) {
+            // For positron emission, continue as usual
+            if (beta->getPositronIntensity() > epsilon && rndm->getUniform() < beta->getPositronIntensity()) {
 
-                }
-                else {
+            }
+            else {
 
-                    if (relaxationType == "eadl" && (*beta)->ecShellIntensity.size()) {
-                        // Determine which shell the electron capture
-                        // occurs in. This will create a shell vacancy
-                        EGS_Float u3 = rndm->getUniform();
+                if (eadlRelaxations && beta->ecShellIntensity.size()) {
+                    // Determine which shell the electron capture
+                    // occurs in. This will create a shell vacancy
+                    EGS_Float u3 = rndm->getUniform();
 
-                        for (unsigned int i=0; i<(*beta)->ecShellIntensity.size(); ++i) {
-                            if (u3 < (*beta)->ecShellIntensity[i]) {
+                    for (unsigned int j=0; j<beta->ecShellIntensity.size(); ++j) {
+                        if (u3 < beta->ecShellIntensity[j]) {
 
-                                // Generate relaxation particles for a
-                                // shell vacancy i
-                                (*beta)->relax(i,app->getEcut()-app->getRM(),app->getPcut(),rndm,edep,relaxParticles);
+                            // Generate relaxation particles for a
+                            // shell vacancy j
+                            beta->relax(j,app->getEcut()-app->getRM(),app->getPcut(),rndm,edep,relaxParticles);
 
-                                emissionType = 4;
+                            emissionType = 4;
 
-                                return 0;
-                            }
+                            return 0;
                         }
                     }
-
-                    // For electron capture, there is no emitted particle
-                    // (only a neutrino)
-                    // so we return a 0 energy particle
-                    emissionType = 4;
-                    return 0;
                 }
-                emissionType = 5;
-            }
-            else {
-                emissionType = 6;
+
+                // For electron capture, there is no emitted particle
+                // (only a neutrino)
+                // so we return a 0 energy particle
+                emissionType = 4;
+                return 0;
             }
+            emissionType = 5;
+        }
+        else {
+            emissionType = 6;
+        }
 
-            // Sample the energy from the spectrum alias table
-            E = (*beta)->getSpectrum()->sample(rndm);
+        // Sample the energy from the spectrum alias table
+        E = beta->getSpectrum()->sample(rndm);
 
-            return E;
-        }
+        return E;
     }
 
     // Alphas
-    for (vector<AlphaRecord *>::iterator alpha = myAlphas.begin();
-            alpha != myAlphas.end(); alpha++) {
-        if (u < (*alpha)->getAlphaIntensity()) {
+    case AlphaBranch: {
+        AlphaRecord *alpha = myAlphas[i];
 
-            // Increment the shower number
-            ishower++;
+        // Increment the shower number
+        ishower++;
 
-            // Increment the counter of alphas and get the charge
-            (*alpha)->incrNumSampled();
-            currentQ = (*alpha)->getCharge();
+        // Increment the counter of alphas and get the charge
+        alpha->incrNumSampled();
+        currentQ = alpha->getCharge();
 
-            // Set the energy level of the daughter
-            currentLevel = (*alpha)->getLevelRecord();
+        // Set the energy level of the daughter
+        currentLevel = branchLevel[ibranch];
 
-            // Score alpha energy depositions locally,
-            // because alpha transport is not modeled in EGSnrc.
-            // This is an approximation!
-            if (scoreAlphasLocal) {
-                edep += (*alpha)->getFinalEnergy();
-            }
+        // Score alpha energy depositions locally,
+        // because alpha transport is not modeled in EGSnrc.
+        // This is an approximation!
+        if (scoreAlphasLocal) {
+            edep += alpha->getFinalEnergy();
+        }
 
-            emissionType = 7;
+        emissionType = 7;
 
-            // For alphas we simulate a disintegration but the
-            // transport will not be performed so return 0
-            return 0;
-        }
+        // For alphas we simulate a disintegration but the
+        // transport will not be performed so return 0
+        return 0;
     }
 
     // Metastable "decays" that will result in internal transitions
-    for (vector<GammaRecord *>::iterator gamma = myMetastableGammas.begin();
-            gamma != myMetastableGammas.end(); gamma++) {
-        if (u < (*gamma)->getTransitionIntensity()) {
+    case MetastableBranch: {
 
-            // Increment the shower number
-            ishower++;
+        // Increment the shower number
+        ishower++;
 
-            // Set the energy level of the daughter as though a
-            // disintegration just occurred
-            currentLevel = (*gamma)->getLevelRecord();
+        // Set the energy level of the daughter as though a
+        // disintegration just occurred
+        currentLevel = branchLevel[ibranch];
 
-            emissionType = 8;
+        emissionType = 8;
 
-            // No particle returned
-            return 0;
-        }
+        // No particle returned
+        return 0;
     }
 
     // Uncorrelated internal transitions
-    for (vector<GammaRecord *>::iterator gamma = myUncorrelatedGammas.begin();
-            gamma != myUncorrelatedGammas.end(); gamma++) {
-        if (u < (*gamma)->getTransitionIntensity()) {
-
-            // A gamma transition may either be a gamma emission
-            // or an internal conversion electron
-            EGS_Float u2 = 0;
-            if ((*gamma)->getGammaIntensity() < 1) {
-                u2 = rndm->getUniform();
-            }
-
-            // If a gamma emission occurs
-            if (u2 < (*gamma)->getGammaIntensity()) {
+    case UncorrelatedBranch: {
+        GammaRecord *gamma = myUncorrelatedGammas[i];
+
+        // A gamma transition may either be a gamma emission
+        // or an internal conversion electron
+        EGS_Float u2 = 0;
+        if (gamma->getGammaIntensity() < 1) {
+            u2 = rndm->getUniform();
+        }
 
-                (*gamma)->incrGammaSampled();
+        // If a gamma emission occurs
+        if (u2 < gamma->getGammaIntensity()) {
 
-                currentQ = (*gamma)->getCharge();
+            gamma->incrGammaSampled();
 
-                E = (*gamma)->getDecayEnergy();
+            currentQ = gamma->getCharge();
 
-                totalGammaEnergy += E;
+            E = gamma->getDecayEnergy();
 
-                emissionType = 11;
+            totalGammaEnergy += E;
 
-                return E;
+            emissionType = 11;
 
-            }
-            else if (u2 < (*gamma)->getICIntensity()) {
-                (*gamma)->incrICSampled();
-                currentQ = -1;
-                emissionType = 12;
+            return E;
 
-                if ((*gamma)->icIntensity.size()) {
+        }
+        else if (u2 < gamma->getICIntensity()) {
+            gamma->incrICSampled();
+            currentQ = -1;
+            emissionType = 12;
 
-                    // Determine which shell the conversion electron
-                    // comes from. This will create a shell vacancy
-                    EGS_Float u3 = rndm->getUniform();
+            if (gamma->icIntensity.size()) {
 
-                    for (unsigned int i=0; i<(*gamma)->icIntensity.size(); ++i) {
-                        if (u3 < (*gamma)->icIntensity[i]) {
+                // Determine which shell the conversion electron
+                // comes from. This will create a shell vacancy
+                EGS_Float u3 = rndm->getUniform();
 
-                            E = (*gamma)->getDecayEnergy() - (*gamma)->getBindingEnergy(i);
+                for (unsigned int j=0; j<gamma->icIntensity.size(); ++j) {
+                    if (u3 < gamma->icIntensity[j]) {
 
-                            // Add relaxation particles to the source stack
-                            if (relaxationType == "eadl") {
+                        E = gamma->getDecayEnergy() - gamma->getBindingEnergy(j);
 
-                                // Generate relaxation particles for a
-                                // shell vacancy i
-                                (*gamma)->relax(i,app->getEcut()-app->getRM(),app->getPcut(),rndm,edep,relaxParticles);
-                            }
+                        // Add relaxation particles to the source stack
+                        if (eadlRelaxations) {
 
-                            // Return the conversion electron
-                            return E;
+                            // Generate relaxation particles for a
+                            // shell vacancy j
+                            gamma->relax(j,app->getEcut()-app->getRM(),app->getPcut(),rndm,edep,relaxParticles);
                         }
+
+                        // Return the conversion electron
+                        return E;
                     }
                 }
-                return 0;
             }
-            else {
-                (*gamma)->incrIPSampled();
-                emissionType = 14;
+            return 0;
+        }
+        else {
+            gamma->incrIPSampled();
+            emissionType = 14;
 
-                // Internal pair production results in a positron
-                // and electron pair
+            // Internal pair production results in a positron
+            // and electron pair
 
-                //TODO: This is left for future work, we need to
-                // determine the energies of the electron/positron
-                // pair (sample uniformly?) and then determine the
-                // corresponding directions. It might be best to do
-                // this in the source instead of the spectrum.
+            //TODO: This is left for future work, we need to
+            // determine the energies of the electron/positron
+            // pair (sample uniformly?) and then determine the
+            // corresponding directions. It might be best to do
+            // this in the source instead of the spectrum.
 
-                currentQ = 1;
-                return 0;
-            }
+            currentQ = 1;
+            return 0;
         }
     }
 
     // XRays from the ensdf
-    for (unsigned int i=0; i < xrayIntensities.size(); ++i) {
-        if (u < xrayIntensities[i]) {
+    case XRayBranch:
 
-            numSampledXRay[i]++;
-            currentQ = 0;
+        numSampledXRay[i]++;
+        currentQ = 0;
 
-            E = xrayEnergies[i];
+        E = xrayEnergies[i];
 
-            emissionType = 9;
+        emissionType = 9;
 
-            return E;
-        }
-    }
+        return E;
 
     // Auger electrons from the ensdf
-    for (unsigned int i=0; i < augerIntensities.size(); ++i) {
-        if (u < augerIntensities[i]) {
+    case AugerBranch:
 
-            numSampledAuger[i]++;
-            currentQ = -1;
+        numSampledAuger[i]++;
+        currentQ = -1;
 
-            E = augerEnergies[i];
+        E = augerEnergies[i];
 
-            emissionType = 10;
+        emissionType = 10;
 
-            return E;
-        }
+        return E;
+
+    default:
+        break;
     }
 
     // If we get here, fission occurs
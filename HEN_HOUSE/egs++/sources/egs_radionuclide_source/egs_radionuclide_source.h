@@ -86,13 +86,24 @@ class EGS_EXPORT EGS_RadionuclideBetaSpectrum {
 public:
     /*! \brief Construct beta spectra for a radionuclide
      */
-    EGS_RadionuclideBetaSpectrum(EGS_Ensdf *decays, const string outputBetaSpectra) {
+    EGS_RadionuclideBetaSpectrum(EGS_Ensdf *decays, const string outputBetaSpectra, const bool cacheSpectra=false) {
 
         EGS_Application *app = EGS_Application::activeApplication();
         rm = app->getRM();
 
         vector<BetaRecordLeaf *> myBetas = decays->getBetaRecords();
 
+        // With caching, spectra computed by a previous run for the same
+        // beta parameters are read from a file in the application directory
+        string cacheFile;
+        vector<CachedSpectrum> cached, current;
+        bool cacheChanged = false;
+        if (cacheSpectra) {
+            cacheFile = egsJoinPath(app->getAppDir(),
+                                    decays->radionuclide + ".betaspectra");
+            readCache(cacheFile,cached);
+        }
+
         for (vector<BetaRecordLeaf *>::iterator beta = myBetas.begin();
                 beta != myBetas.end(); beta++) {
 
@@ -176,29 +187,57 @@ public:
             // /=     NBIN
             //cout << "Binwidth " << de << endl;
 
-            for (int ib=0; ib<nbin; ib++) {
-                e[ib]=de+ib*de;
-//                 egsInformation("%.12f, %.12f\n", e[ib], etop[0]);
+            CachedSpectrum entry;
+            entry.key[0] = emax;
+            entry.key[1] = zzz[0];
+            entry.key[2] = rmass;
+            entry.key[3] = lamda[0];
+            entry.key[4] = rm;
+            const CachedSpectrum *found = 0;
+            for (unsigned int j=0; j<cached.size(); j++) {
+                if (cached[j].matches(entry) && cached[j].e.size() == nbin) {
+                    found = &cached[j];
+                    break;
+                }
             }
 
-            s_y=0.0;
-            se_y=0.0;
-            for (int ib=0; ib<nbin; ib++) {
-
-                if (e[ib]<=emax) {
-                    sp(e[ib],spec_y[ib],factor);
+            if (found) {
+                for (int ib=0; ib<nbin; ib++) {
+                    e[ib]=found->e[ib];
+                    spec[ib]=found->spec[ib];
                 }
-                else {
-                    spec_y[ib]=0.0;
+            }
+            else {
+                for (int ib=0; ib<nbin; ib++) {
+                    e[ib]=de+ib*de;
+//                     egsInformation("%.12f, %.12f\n", e[ib], etop[0]);
                 }
 
-                s_y=s_y+spec_y[ib];
-                se_y=se_y+spec_y[ib]*e[ib];
-            }
+                s_y=0.0;
+                se_y=0.0;
+                for (int ib=0; ib<nbin; ib++) {
+
+                    if (e[ib]<=emax) {
+                        sp(e[ib],spec_y[ib],factor);
+                    }
+                    else {
+                        spec_y[ib]=0.0;
+                    }
+
+                    s_y=s_y+spec_y[ib];
+                    se_y=se_y+spec_y[ib]*e[ib];
+                }
 
-            for (int ib=0; ib<nbin; ib++) {
-                spec[ib]=1/de*(spec_y[ib]/s_y);
-//                 cout << e[ib] << " " << spec[ib] << endl;
+                for (int ib=0; ib<nbin; ib++) {
+                    spec[ib]=1/de*(spec_y[ib]/s_y);
+//                     cout << e[ib] << " " << spec[ib] << endl;
+                }
+                cacheChanged = true;
+            }
+            if (cacheSpectra) {
+                entry.e.assign(e,e+nbin);
+                entry.spec.assign(spec,spec+nbin);
+                current.push_back(entry);
             }
 
             EGS_AliasTable *bspec = new EGS_AliasTable(nbin,e,spec,1);
@@ -215,16 +254,127 @@ public:
                 ofstream specStream;
                 specStream.open(ostr.str().c_str());
                 for (int ib=0; ib<nbin; ib++) {
-                    spec[ib]=1/de*(spec_y[ib]/s_y);
                     specStream << e[ib] << " " << spec[ib] << endl;
                 }
                 specStream.close();
             }
+            delete [] spec_y;
+            delete [] spec;
+            delete [] e;
+        }
+
+        if (cacheSpectra && cacheChanged) {
+            writeCache(cacheFile,current);
         }
     }
 
 protected:
 
+    /*! \brief A tabulated beta spectrum in the spectra cache.
+     *
+     * The key holds the endpoint energy, the daughter Z (negative for
+     * positrons), the atomic weight, the shape factor type and the electron
+     * rest energy, i.e. all inputs of the spectrum calculation.
+     */
+    struct CachedSpectrum {
+        double key[5];
+        vector<EGS_Float> e, spec;
+        bool matches(const CachedSpectrum &o) const {
+            for (int j=0; j<5; j++) {
+                if (key[j] != o.key[j]) {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    /*! \brief Reads the spectra cache \a fname into \a spectra.
+     *
+     * A missing or unreadable file (e.g. one written with a different
+     * EGS_Float type) leaves \a spectra empty.
+     */
+    void readCache(const string &fname, vector<CachedSpectrum> &spectra) {
+        ifstream in(fname.c_str(),ios::binary);
+        if (!in) {
+            return;
+        }
+        char magic[16];
+        int fsize, nspec;
+        in.read(magic,16);
+        magic[15] = '\0';
+        in.read((char *)&fsize,sizeof(int));
+        in.read((char *)&nspec,sizeof(int));
+        if (!in.good() || string(magic) != cacheMagic() ||
+                fsize != sizeof(EGS_Float) || nspec < 0) {
+            return;
+        }
+        for (int j=0; j<nspec; j++) {
+            CachedSpectrum c;
+            int nbin;
+            in.read((char *)c.key,5*sizeof(double));
+            in.read((char *)&nbin,sizeof(int));
+            if (!in.good() || nbin < 1) {
+                spectra.clear();
+                return;
+            }
+            c.e.resize(nbin);
+            c.spec.resize(nbin);
+            in.read((char *)&c.e[0],nbin*sizeof(EGS_Float));
+            in.read((char *)&c.spec[0],nbin*sizeof(EGS_Float));
+            if (!in.good()) {
+                spectra.clear();
+                return;
+            }
+            spectra.push_back(c);
+        }
+        egsInformation("EGS_RadionuclideBetaSpectrum: Read %d beta spectra "
+                       "from %s\n",nspec,fname.c_str());
+    }
+
+    /*! \brief Writes \a spectra to the spectra cache \a fname.
+     *
+     * The file is written under a temporary name and then renamed, so that
+     * parallel jobs never read a partially written cache.
+     */
+    void writeCache(const string &fname, const vector<CachedSpectrum> &spectra) {
+        EGS_Application *app = EGS_Application::activeApplication();
+        ostringstream tmp;
+        tmp << fname << ".tmp" << app->getIparallel();
+        ofstream out(tmp.str().c_str(),ios::binary);
+        if (!out) {
+            egsWarning("EGS_RadionuclideBetaSpectrum: failed to open %s for "
+                       "writing\n",tmp.str().c_str());
+            return;
+        }
+        string magic(cacheMagic());
+        magic.resize(16,'\0');
+        int fsize = sizeof(EGS_Float), nspec = spectra.size();
+        out.write(magic.c_str(),16);
+        out.write((const char *)&fsize,sizeof(int));
+        out.write((const char *)&nspec,sizeof(int));
+        for (int j=0; j<nspec; j++) {
+            int nbin = spectra[j].e.size();
+            out.write((const char *)spectra[j].key,5*sizeof(double));
+            out.write((const char *)&nbin,sizeof(int));
+            out.write((const char *)&spectra[j].e[0],nbin*sizeof(EGS_Float));
+            out.write((const char *)&spectra[j].spec[0],nbin*sizeof(EGS_Float));
+        }
+        out.close();
+        if (!out.good() || rename(tmp.str().c_str(),fname.c_str())) {
+            egsWarning("EGS_RadionuclideBetaSpectrum: failed to write beta "
+                       "spectra cache %s\n",fname.c_str());
+            remove(tmp.str().c_str());
+            return;
+        }
+        egsInformation("EGS_RadionuclideBetaSpectrum: Wrote %d beta spectra "
+                       "to %s\n",nspec,fname.c_str());
+    }
+
+    static const char *cacheMagic() {
+        return "EGS_BetaSpec 1";
+    }
+
     complex<double> cgamma(complex<double> z) {
 
         static const int g=7;
@@ -562,6 +712,15 @@ It is defined using the following input
                             Files will be named based on the nuclide and
                             maximum energy of the beta decay:
                             {nuclide}_{energy}.spec
+    cache beta spectra  = [optional, default=no] yes or no
+                            whether or not to store the computed beta spectra
+                            in the file {nuclide}.betaspectra in the
+                            application directory. Later runs (and the other
+                            jobs of a parallel run) read the spectra from this
+                            file instead of recomputing them. Entries are
+                            matched on the beta endpoint energy, daughter Z,
+                            atomic weight and shape factor, so a modified
+                            ensdf file only recomputes the changed spectra.
     alpha scoring       = [optional, default=none] none or local
                             Whether or not to deposit alpha particles locally.
                             Since alpha particles are not transported in EGSnrc,
@@ -648,7 +807,7 @@ public:
     /*! \brief Construct a radionuclide spectrum.
      */
     EGS_RadionuclideSpectrum(const string nuclide, const string ensdf_file,
-                             const EGS_Float relativeActivity, const string relaxType, const string outputBetaSpectra, const bool scoreAlphasLocally, const bool allowMultiTransition);
+                             const EGS_Float relativeActivity, const string relaxType, const string outputBetaSpectra, const bool scoreAlphasLocally, const bool allowMultiTransition, const bool cacheBetaSpectra=false);
 
     /*! \brief Destructor. */
     ~EGS_RadionuclideSpectrum() {
@@ -658,6 +817,18 @@ public:
         if (betaSpectra) {
             delete betaSpectra;
         }
+        if (nbranch > 0) {
+            delete branchTable;
+            delete [] branchType;
+            delete [] branchIndex;
+            delete [] branchLevel;
+        }
+        delete [] levelActive;
+        delete [] levelHalfLife;
+        delete [] levelFirst;
+        delete [] transGamma;
+        delete [] transIntensity;
+        delete [] transFinal;
     };
 
     /*! \brief Returns the maximum energy that may be emitted.
@@ -740,7 +911,7 @@ public:
     }
 
     void resetCounter() {
-        currentLevel = 0;
+        currentLevel = -1;
         currentTime = 0;
         ishower = -1;
         totalGammaEnergy = 0;
@@ -751,6 +922,35 @@ public:
 
 private:
 
+    /*! \brief Types of the branches in the disintegration table */
+    enum BranchType { BetaBranch, AlphaBranch, MetastableBranch,
+                      UncorrelatedBranch, XRayBranch, AugerBranch,
+                      FissionBranch
+                    };
+
+    /*! \brief Builds the alias table over all disintegration branches
+     *
+     * Replaces the sequential search through the beta, alpha, metastable,
+     * uncorrelated gamma, x-ray and Auger records in sample() with a
+     * single table lookup.
+     */
+    void buildBranchTable();
+
+    /*! \brief Builds the per-level transition tables
+     *
+     * The gamma transitions are stored contiguously, grouped by their
+     * initial level, so that a transition from the current level is
+     * sampled without searching through all gamma records. Levels are
+     * referred to by their index in levelRecords.
+     */
+    void buildLevelTables();
+
+    /*! \brief Adds \a level to levelRecords, if not already there */
+    void addLevel(const LevelRecord *level);
+
+    /*! \brief The index of \a level in levelRecords (-1 if not found) */
+    int findLevel(const LevelRecord *level) const;
+
     EGS_Ensdf                   *decays;
     vector<BetaRecordLeaf *>    myBetas;
     vector<AlphaRecord *>       myAlphas;
@@ -764,9 +964,9 @@ private:
            augerEnergies;
     vector<EGS_I64>             numSampledXRay,
            numSampledAuger;
-    vector<const LevelRecord *> multiTransitions;
+    vector<int>                 multiTransitions;
     EGS_SimpleContainer<EGS_RelaxationParticle> relaxParticles;
-    const LevelRecord           *currentLevel;
+    int                         currentLevel; //!< daughter level index, -1 if none
     int                         currentQ;
     unsigned int                emissionType;
     EGS_Float                   currentTime,
@@ -776,10 +976,27 @@ private:
                                 edep;
     EGS_I64                     ishower;
     string                      relaxationType;
-    bool                        scoreAlphasLocal;
+    bool                        eadlRelaxations,
+                                scoreAlphasLocal;
 
     EGS_RadionuclideBetaSpectrum *betaSpectra;
     EGS_Application             *app;
+
+    int                         nbranch;     //!< number of branches
+    int                         *branchType; //!< BranchType of each branch
+    int                         *branchIndex;//!< record index of each branch
+    int                         *branchLevel;//!< daughter level of each branch
+    EGS_SimpleAliasTable        *branchTable;//!< branch sampling table
+
+    vector<const LevelRecord *> levelRecords;  //!< the daughter levels
+    int                         nlevel;        //!< number of levels
+    bool                        *levelActive;  //!< level has transitions
+    double                      *levelHalfLife;//!< half-life of each level
+    int                         *levelFirst;   //!< first transition of each level
+    int                         ntrans;        //!< number of transitions
+    GammaRecord                 **transGamma;  //!< gamma record of each transition
+    double                      *transIntensity;//!< cumulative transition intensity
+    int                         *transFinal;   //!< final level of each transition
 };
 
 /*! \brief A radionuclide source.
@@ -164,6 +164,16 @@ public:
         }
         return c;
     };
+    EGS_I64 getNextParticles(EGS_RandomGenerator *rndm, int n,
+                             int *q, int *latch, EGS_Float *E, EGS_Float *wt,
+                             EGS_Vector *x, EGS_Vector *u, EGS_I64 *icase = 0) {
+        EGS_I64 c = source->getNextParticles(rndm,n,q,latch,E,wt,x,u,icase);
+        if (T) {
+            T->rotate(n,u);
+            T->transform(n,x);
+        }
+        return c;
+    };
     EGS_Float getEmax() const {
         return source->getEmax();
     };
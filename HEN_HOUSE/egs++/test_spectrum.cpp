@@ -55,9 +55,26 @@ int main(int argc, char **argv) {
         ncase = 1000000;
     }
 
+    // With 'batch size' in the input, sample the energies in batches
+    // using EGS_BaseSpectrum::sampleEnergies()
+    int nbatch;
+    err = input.getInput("batch size",nbatch);
+    if (err || nbatch < 1) {
+        nbatch = 0;
+    }
+
     EGS_Timer t;
-    for (int j=0; j<ncase; j++) {
-        spec->sampleEnergy(rndm);
+    if (nbatch > 0) {
+        EGS_Float *E = new EGS_Float [nbatch];
+        for (int j=0; j<ncase; j+=nbatch) {
+            spec->sampleEnergies(rndm,ncase-j < nbatch ? ncase-j : nbatch,E);
+        }
+        delete [] E;
+    }
+    else {
+        for (int j=0; j<ncase; j++) {
+            spec->sampleEnergy(rndm);
+        }
     }
     EGS_Float cpu = t.time();
     egsInformation("CPU time: %g\n",cpu);
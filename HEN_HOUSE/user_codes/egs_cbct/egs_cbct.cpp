@@ -77,7 +77,7 @@ class EGS_RectangularBeam;
 EGS_CBCTSetup::EGS_CBCTSetup():
 angle(0), step(1), orbit(360), irot(2),
 amin(0), amax(0), nproj(360), iproj(-1),
-defined(false), swap(false)
+defined(false), swap(false), all(false)
 {
     defined = true; iproj=0;
     EGS_RotationMatrix m = EGS_RotationMatrix();//unit matrix
@@ -89,9 +89,9 @@ defined(false), swap(false)
    and axis and sets up the proper transformation.
 */
 EGS_CBCTSetup::EGS_CBCTSetup(EGS_Input *i):
-angle(0), step(1), orbit(360),
+angle(0), step(1), orbit(360), irot(2),
 amin(0), amax(0), nproj(360), iproj(-1),
-defined(false), swap(false)
+defined(false), swap(false), all(false)
 {
 
     EGS_RotationMatrix rm = EGS_RotationMatrix();
@@ -202,6 +202,12 @@ defined(false), swap(false)
         allowed_types.push_back("yes"); allowed_types.push_back("no");
         int scan_swap = setup->getInput("swap",allowed_types,1);
         if( scan_swap == 0 ) swap = true;
+
+        //
+        // ***** scan mode: all projections of the orbit in one run
+        //
+        int scan_all = setup->getInput("all projections",allowed_types,1);
+        if( scan_all == 0 ) all = true;
     }
     else{
      egsWarning("\n\n*** No CBCT setup input block found!!!!\n");
@@ -231,6 +237,18 @@ void EGS_CBCTSetup::setup(const EGS_Float & a,
    defined = true; swap=false;
 }
 
+/*
+   CBCT setup: Rotates source and scoring plane to projection ip
+   of the orbit. Used when computing all projections in one run.
+*/
+void EGS_CBCTSetup::setProjection(int ip){
+   iproj = ip; angle = amin + ip*step;
+   if(      irot == 0 ) R = EGS_RotationMatrix(angle,0,0);
+   else if( irot == 1 ) R = EGS_RotationMatrix(0,angle,0);
+   else                 R = EGS_RotationMatrix(0,0,angle);
+   if( R.isI() ) has_R = false; else has_R = true;
+}
+
 void EGS_CBCTSetup::describeMe(){
     if (orbit != 0 && step != 0 ){
      EGS_Float convert = Pi/180.;
@@ -242,6 +260,7 @@ void EGS_CBCTSetup::describeMe(){
      egsInformation("step = %g degrees\n",step/convert);
      if(hasTranslation()) egsInformation("translation = (%g, %g, %g)\n",t.x,t.y,t.z);
      if (swap) egsInformation("Writting X coordinates as Y coordinates.\n");
+     if (all) egsInformation("Computing all %d projections in one run.\n",steps());
      if(hasRotation()){
        if(      irot == 0 ) egsInformation("CBCT rotation around x-axis\n");
        else if( irot == 1 ) egsInformation("CBCT rotation around y-axis\n");
@@ -285,7 +304,8 @@ EGS_CBCT::EGS_CBCT(int argc, char **argv) :
         cbctS(0), scan_type(none), split_type(no_split), rhormax(1),d_split(-1),
         error_estimation(0), split_geom(0), pnorm(1), m_real(0), m_blank(0),
         nmax(10), nmax2d(6), chi2max(2), dmin(0.02), do_smoothing(false),
-        splitter(0), c_att(0), C_imp(1), C_imp_save(1), ray_tracing(false)
+        splitter(0), c_att(0), C_imp(1), C_imp_save(1), ray_tracing(false),
+        scan_all(false), scan_blank(0), pselector(0)
 {
         gsections = new EGS_GeometryIntersections[isize];
         //hist = new EGS_Hist(100.,1024);
@@ -304,6 +324,7 @@ EGS_CBCT::~EGS_CBCT() {
    if( cbctS ) delete cbctS;
    if( splitter ) delete splitter;
    if( c_att ) delete c_att;
+   if( scan_blank ) delete [] scan_blank;
    //if(hist) delete hist;
 }
 
@@ -959,6 +980,11 @@ int EGS_CBCT::initScoring() {
         else if( itype == 2 ) type = both;
         else if( itype == 3 ){type = planar; ray_tracing=true;}
         else                  type = planar;
+        if( cbctS->allProjections() ){
+            if( ray_tracing ) scan_all = true;
+            else egsWarning("\n\n*** All projections in one run only available\n"
+                            "    for ray-tracing calculations. Ignoring request!\n\n");
+        }
 
         /*get angular rotation information in degrees and convert to radians*/
         EGS_Float convert = Pi/180.;
@@ -1130,15 +1156,11 @@ int EGS_CBCT::initScoring() {
                 delete t;
             }
 
-            /* transformation requested: usually CBCT rotation, but also origin translation */
-            cbctS->rotate(a); cbctS->transform(midpoint);
-            cbctS->rotate(ux);cbctS->rotate(uy);
-
-            /* distance from origin to plane midpoint */
-            distance = a*midpoint;
+            /* keep the plane before the CBCT rotation for scan mode */
+            a0 = a; midpoint0 = midpoint; ux0 = ux; uy0 = uy;
 
-            /* Point selector on the screen */
-            pselector = new EGS_PlanePointSelector(midpoint,ux,uy,ax,ay,Nx,Ny);
+            /* transformation requested: usually CBCT rotation, but also origin translation */
+            positionScreen();
 
             /* get E*muen/rho values */
             string muen_file;
@@ -1245,6 +1267,15 @@ int EGS_CBCT::initScoring() {
     //            **** output options ****
     //**************************************************
     initOutput();
+    if( scan_all ){
+        if( !real_scan.length() || (scan_type != ideal && scan_type != blank) )
+            egsFatal("\n\n*** All projections in one run requested but no\n"
+                     "    'scan file' or no ideal/blank 'scan type' defined.\n"
+                     "    This is a fatal error\n\n");
+        // each projection is written to the scan file as soon as it is
+        // done, storing the scoring arrays of the last one is pointless
+        egsdat = false;
+    }
     //**************************************************
     //           **** variance reduction ****
     //**************************************************
@@ -2827,7 +2858,11 @@ cout << "->projection # " << cbctS->atStep() << " out of " << cbctS->steps() <<
         // write total kerma to the proper position on the
         // projection file
 
-        /* read in blank scan values of Kerma */
+        /* read in blank scan values of Kerma, unless already done */
+        if (scan_blank){
+             for (EGS_I32 i = 0; i<Nx*Ny; i++){blank[i]=scan_blank[i];}
+        }
+        else{
         EGS_BinaryFile *blank_file = new EGS_BinaryFile(blank_scan.c_str());
         if (blank_file->fileSize()==Nx*Ny*sizeof(float)){
              blank = blank_file->readValues();
@@ -2842,6 +2877,7 @@ cout << "->projection # " << cbctS->atStep() << " out of " << cbctS->steps() <<
         }
         // delete blank scan file since no longer needed
         delete blank_file;
+        }
         /* create a real scan */
         if ( real_scan.length() && scan_type != ideal ){// it's real, both or all
            float *scan = getArray(kermaT);
@@ -2963,11 +2999,107 @@ cout << "->projection # " << cbctS->atStep() << " out of " << cbctS->steps() <<
 
 }
 
+/*! Rotates the scoring plane to the current CBCT projection. */
+void EGS_CBCT::positionScreen() {
+    a = a0; midpoint = midpoint0; ux = ux0; uy = uy0;
+    cbctS->rotate(a); cbctS->transform(midpoint);
+    cbctS->rotate(ux);cbctS->rotate(uy);
+
+    /* distance from origin to plane midpoint */
+    distance = a*midpoint;
+
+    /* Point selector on the screen */
+    if (pselector) delete pselector;
+    pselector = new EGS_PlanePointSelector(midpoint,ux,uy,ax,ay,Nx,Ny);
+}
+
+int EGS_CBCT::runSimulation() {
+    if (!scan_all) return EGS_AdvancedApplication::runSimulation();
+    return runScan();
+}
+
+/*! Computes all projections of the orbit in one run.
+
+    Geometry, cross sections, mu tables and the blank scan are set up
+    only once. Each projection is one batch of ncase histories and is
+    written to the scan file as soon as it is done. In a parallel run
+    job i computes the projections i, i+n, i+2n, ... of the orbit, n
+    being the number of parallel jobs. Every projection is computed with
+    ncase histories: a statistical accuracy sought in the run control
+    input is ignored, as it would end the scan after the first projection
+    reaching it. The scan only stops early if the cpu time limit is
+    reached, in which case a warning lists the missing projections. Only
+    available for ray-tracing calculations.
+*/
+int EGS_CBCT::runScan() {
+    if (!geometry || !source || !rndm || !run) return 1;
+    int start_status = run->startSimulation();
+    if (start_status) {
+        if (start_status > 0) egsWarning("\n\n*** Restarting or combining "
+            "results not possible when computing all projections!\n\n");
+        return start_status;
+    }
+
+    if (blank_scan.length() && scan_type != blank){
+        EGS_BinaryFile *blank_file = new EGS_BinaryFile(blank_scan.c_str());
+        if (blank_file->fileSize()==Nx*Ny*sizeof(float)){
+            scan_blank = new float[Nx*Ny];
+            blank_file->readValues(scan_blank,Nx*Ny);
+        }
+        delete blank_file;
+    }
+
+    int nproj = cbctS->steps(), ijob = 0, njob = 1;
+    if (getNparallel() > 0){
+        njob = getNparallel(); ijob = getIparallel() - getFirstParallel();
+    }
+    EGS_I64 ncase = run->getNcase();
+    // a scan needs every projection => ncase histories for each of them
+    if (run->getRequiredUncertainty() > 0){
+        egsWarning("\n*** 'statistical accuracy sought' is ignored when "
+                   "computing all projections,\n    each projection is "
+                   "computed with ncase histories\n");
+        run->setRequiredUncertainty(-1);
+    }
+    egsInformation("\nComputing projections %d to %d (every %d) with %lld"
+                   " histories each\n\n",ijob,nproj-1,njob,ncase);
+
+    for (int iproj=ijob, ibatch=0; iproj<nproj; iproj+=njob, ibatch++){
+        cbctS->setProjection(iproj); positionScreen();
+        kermaT->reset(); kermaA->reset(); kermaS->reset(); cker->reset();
+        source->resetCounter(); current_case = 0; last_case = 0;
+        if (!run->startBatch(ibatch,ncase)){
+            egsWarning("\n*** cpu time limit reached: the scan file is "
+                       "missing projections %d to %d (every %d)\n\n",
+                       iproj,nproj-1,njob);
+            break;
+        }
+        // time indices are sorted per projection, see runSimulation()
+        time_block_left = ncase; time_block_n = time_block_i = 0;
+        bool ok = true;
+        for (EGS_I64 icase=0; icase<ncase; icase++){
+            if (simulateSingleShower()){
+                egsInformation("  simulateSingleShower() loop termination\n");
+                ok = false; break;
+            }
+            --time_block_left;
+        }
+        time_block_left = 0;
+        if (!ok) break;
+        run->finishBatch();
+        printScans();
+    }
+    return 0;
+}
+
 /*! Output the results of a simulation. */
 int EGS_CBCT::finishSimulation() {
     int err = EGS_Application::finishSimulation();
     egsInformation("finishSimulation(%s) %d\n",app_name.c_str(),err);
 
+    // projections already written to the scan file by each job
+    if( scan_all ) return err < 0 ? err : 0;
+
     if( err <= 0 ) {// interactive run or not last parallel job
        if (getNparallel()==0) {// interactive run
           egsInformation("\n Running an interactive job!!!\n\n");
@@ -74,6 +74,10 @@ public:
       EGS_Float getStep(){return step;};
       int       steps(){return nproj>0? nproj:-nproj;};
       EGS_Float atStep(){return iproj > 0? iproj:-iproj;};
+      /*! True if all projections of the orbit are requested in one run */
+      bool allProjections(){return all;};
+      /*! Rotates the setup to projection \a ip of the orbit */
+      void setProjection(int ip);
       void setup(const EGS_Float & a,
                  const EGS_Float & s,
                  const EGS_Float & o,
@@ -90,7 +94,8 @@ int       iproj, // projection index, if not provided, defaults to -1
           nproj, // number of projections, defaults to 360
            irot; // 0 -> x, 1 -> y, 2 -> z axis rotation
 bool defined,
-     swap;// swap X scan coordinates to Y scan coordinates
+     swap,// swap X scan coordinates to Y scan coordinates
+     all; // compute all projections of the orbit in one run
 
 };
 
@@ -238,6 +243,8 @@ public:
 
     /* re-implement here to handle parallel jobs */
     int finishSimulation();
+    /* re-implement here to run all projections of a scan */
+    int runSimulation();
 
 protected:
 
@@ -277,6 +284,10 @@ protected:
     float* getArray(EGS_ScoringArray *array);
 /*  prints scans to file */
     void printScans();
+/*  computes all projections of the orbit in one run */
+    int runScan();
+/*  rotates the scoring plane to the current projection */
+    void positionScreen();
 /*  prints scan results or a requestd profile to file */
     void printProfiles();
 
@@ -410,6 +421,8 @@ private:
     EGS_Vector        a;       // normal a = u x v
     EGS_Vector        ux, uy;  // unit vectors
     EGS_Vector        midpoint;// location
+    EGS_Vector        a0, ux0, uy0,// scoring plane before the CBCT
+                      midpoint0;   // rotation, used in scan mode
     EGS_Float         distance;// distance from source
     EGS_Float         ax, ay;  // rectangular scoring field
     EGS_Float         vx, vy;  // rectangular scoring voxels
@@ -444,6 +457,8 @@ private:
     EGS_CBCTSetup *cbctS; // to rotate source particles and scoring plane
     string blank_scan;
     string real_scan;
+    bool   scan_all;   // all projections in one run (ray-tracing only)
+    float *scan_blank; // blank scan, read once in scan mode
 
     int               nsplit_p, nsplit_s;
     bool              mfptr_do;
@@ -41,6 +41,7 @@
 #include <iostream>
 #include <fstream>
 #include <cmath>
+#include <cfloat>
 
 #include "egs_smoothing.h"
 #include "egs_input.h"
@@ -144,6 +145,64 @@ void EGS_Smoothing::calculateCoefficients(int Ni, int Nj, bool do_norm) {
     setCoefficients();
 }
 
+/* Same as calculateCoefficients(1,nx) but using the summed-area tables.
+   The moments are taken with respect to the centre of the distribution and
+   shifted to the window centre in long double to avoid loss of precision.
+   This only agrees with the direct summation to double rounding if long
+   double has more precision than double, see smooth1(), and even then the
+   sums are rounded differently so a window at the chi2 limit may be
+   decided differently.
+*/
+void EGS_Smoothing::calculateCoefficientsFromTables() {
+    int n1 = nx+1;
+    const long double *t11 = sat + NP_2D*((jj+nj+1)*n1 + ii+ni+1),
+                      *t01 = sat + NP_2D*((jj-nj)*n1 + ii+ni+1),
+                      *t10 = sat + NP_2D*((jj+nj+1)*n1 + ii-ni),
+                      *t00 = sat + NP_2D*((jj-nj)*n1 + ii-ni);
+    long double S[NP_2D];
+    for(int m=0; m<NP_2D; m++) S[m] = t11[m] - t01[m] - t10[m] + t00[m];
+    long double x = ii - nx/2, y = jj - ny/2;
+    s0 = S[0]; si = S[1] - x*S[0]; sj = S[2] - y*S[0];
+    sii = S[3] - 2*x*S[1] + x*x*S[0];
+    sjj = S[4] - 2*y*S[2] + y*y*S[0];
+    sij = S[5] - x*S[2] - y*S[1] + x*y*S[0];
+    N = (2*ni+1)*(2*nj+1);
+    ai = ni*(ni+1); ai /= 3; bi = 0.8*ai - 0.2;
+    aj = nj*(nj+1); aj /= 3; bj = 0.8*aj - 0.2;
+    setCoefficients();
+}
+
+/* Builds the summed-area table of pixels with a positive error and,
+   if moments is true, the tables of the moments of fsmoo1.
+*/
+void EGS_Smoothing::buildTables(bool moments) {
+    int n1 = nx+1;
+    if( !satc ) satc = new int [n1*(ny+1)];
+    if( moments && !sat ) sat = new long double [NP_2D*n1*(ny+1)];
+    for(int i=0; i<n1; i++) satc[i] = 0;
+    if( moments ) for(int m=0; m<NP_2D*n1; m++) sat[m] = 0;
+    for(int j=0; j<ny; j++) {
+        int *tc = satc + (j+1)*n1; tc[0] = 0;
+        int rc = 0;
+        long double r[NP_2D] = {0,0,0,0,0,0}, y = j - ny/2;
+        long double *t = sat + NP_2D*(j+1)*n1;
+        if( moments ) for(int m=0; m<NP_2D; m++) t[m] = 0;
+        for(int i=0; i<nx; i++) {
+            int ireg = j*nx + i;
+            if( error_array[ireg] > 0 ) ++rc;
+            tc[i+1] = tc[i+1-n1] + rc;
+            if( moments ) {
+                long double f = fsmoo1[ireg], x = i - nx/2,
+                            fx = f*x, fy = f*y;
+                r[0] += f; r[1] += fx; r[2] += fy;
+                r[3] += fx*x; r[4] += fy*y; r[5] += fx*y;
+                long double *tt = t + NP_2D*(i+1), *tp = tt - NP_2D*n1;
+                for(int m=0; m<NP_2D; m++) tt[m] = tp[m] + r[m];
+            }
+        }
+    }
+}
+
 void EGS_Smoothing::setCoefficients() {
     pi = si/N/ai; pj = sj/N/aj; pij = sij/(ai*aj*N); p0 = s0/N;
     pii = (sii/ai/N-p0)/bi; pjj = (sjj/aj/N-p0)/bj;
@@ -163,13 +222,23 @@ bool EGS_Smoothing::smooth1D(int iii, int Nx, int Ni, int &Nmax,
         sum0 += fpp; sum1 += fmm; sum2 += fpp*i2; sum3 += fmm*i2;
     }
     while(1) {
+        /* with the count table a window is rejected as soon as the
+           partial chi2 is too large: chi2 can only grow */
+        int nct = -1; double chi2_lim = 1e30;
+        if( satc ) {
+            nct = Ni == 1 && Nx == nx ?
+                  countPositive(iii-Nmax,iii+Nmax,jj,jj) :
+                  countPositive(ii,ii,iii-Nmax,iii+Nmax);
+            if( nct < 4 ) { Nmax = 1; return false; }
+            chi2_lim = chi2_max*(nct-3);
+        }
         N = 2*Nmax+1; ai = Nmax*(Nmax+1); ai /= 3;
         bi = 0.8*ai-0.2;
         p0 = sum0/N; N *= ai; pi = sum1/N; pii = (sum2/N-p0)/bi;
         p0 -= ai*pii; pj = sum1*cc4[Nmax]-sum3*cc5[Nmax];
         pjj = sum3*cc6[Nmax]-sum1*cc5[Nmax];
         double chi2 = 0, chi2a = 0; int nc = 0; se2 = 0;
-        double se2a = 1e30;
+        double se2a = 1e30; bool reject = false;
         for(register int i=-Nmax; i<=Nmax; i++) {
             register int ireg = reg + i*Ni;
             register double df = error_array[ireg];
@@ -177,16 +246,19 @@ bool EGS_Smoothing::smooth1D(int iii, int Nx, int Ni, int &Nmax,
                 ++nc; register double fs = p0 + pi*i + pii*i*i - d_array[ireg];
                 //egsWarning("%d %lg %g %lg\n",i,fs,d_array[ireg],df);
                 chi2 += fs*fs/df;
+                if( chi2 >= chi2_lim ) { reject = true; break; }
                 register double aux1 = 1 + (ai-i*i)/bi;
                 se2 += aux1*aux1*df;
             }
         }
         //egsWarning("nc=%d chi2=%lg chi2max=%lg\n",nc,chi2,chi2_max);
-        if( nc < 4 ) { Nmax = 1; return false; }// minimum possible window np+1
-        if( chi2 < chi2_max*(nc-3) ) {
+        if( !reject ) {
+          if( nc < 4 ) { Nmax = 1; return false; }// minimum possible window np+1
+          if( chi2 < chi2_max*(nc-3) ) {
             N /= ai; se2 /= (N*N); ww = (1+ai/bi)/N;
             //egsWarning("accepting: p0=%lg\n",p0);
             return true;
+          }
         }
         if( Nmax == 2 ) {
             Nmax = 1; return false;
@@ -218,6 +290,33 @@ int EGS_Smoothing::calculateChi2(int Ni, int Nj, double &chi2, double &se2) {
     se2 /= (N*N); return nc;
 }
 
+/* Same as above for a window with nct pixels with a positive error (from
+   the count table). Returns 0 as soon as the partial chi2 shows that the
+   window will fail the chi2 test.
+*/
+int EGS_Smoothing::calculateChi2(int Ni, int Nj, int nct,
+                                 double &chi2, double &se2) {
+    chi2 = se2 = 0;
+    if( nct <= NP_2D ) return nct;
+    double dnc = nct - NP_2D;
+    for(register int j=-nj; j<=nj; j++) {
+        register double tmp1 = p0 + pj*j + pjj*j*j;
+        register double tmp2 = pi + pij*j;
+        register double aux1 = 1 + (aj-j*j)/bj;
+        for(register int i=-ni; i<=ni; i++) {
+            register int ireg = reg + i*Ni + j*Nj;
+            register double df = error_array[ireg];
+            if( df > 0 ) {
+                register double fs = tmp1 + (tmp2+pii*i)*i - d_array[ireg];
+                chi2 += fs*fs/df; register double aux2 = aux1 + (ai-i*i)/bi;
+                se2 += aux2*aux2*df;
+            }
+        }
+        if( chi2/dnc >= chi2_max ) return 0;
+    }
+    se2 /= (N*N); return nct;
+}
+
 EGS_Distribution2D *
 EGS_Smoothing::smooth1(EGS_Distribution2D *the_dose) {
     if( the_dose->nreg != nreg ) {
@@ -240,6 +339,8 @@ EGS_Smoothing::smooth1(EGS_Distribution2D *the_dose) {
         //egsWarning("%d %g %g\n",ii,d_array[ii],error_array[ii]);
     }
 
+    if( use_tables ) buildTables(false);
+
     //------------------------------------------------------
     // Searching for maximum acceptable 1D smoothing window
     //------------------------------------------------------
@@ -278,6 +379,10 @@ EGS_Smoothing::smooth1(EGS_Distribution2D *the_dose) {
     for(reg=0; reg<nreg; reg++) {
         fsmoo1[reg] = fsmoo[reg]; dfsmoo1[reg] = dfsmoo[reg];
     }
+    /* where long double is just double (e.g. MSVC or macOS on arm64) the
+       differences of the moment tables lose the precision of the window
+       sums => keep the direct summation, the count table is exact */
+    if( use_tables && LDBL_MANT_DIG > DBL_MANT_DIG ) buildTables(true);
     for(ii=0; ii<nx; ii++) {
         //egsWarning(".");
         for(jj=0; jj<ny; jj++) {
@@ -298,8 +403,15 @@ EGS_Smoothing::smooth1(EGS_Distribution2D *the_dose) {
                 aj = nj*(nj+1); aj /= 3; bj = 0.8*aj - 0.2;
                 double fakn = (56*ai*aj-9*ai-9*aj+1)/(N*(4*ai-1)*(4*aj-1));
                 if( fakn > fak ) break;
-                calculateCoefficients(1,nx);
-                nc = calculateChi2(1,nx,chi2,se2);
+                if( sat ) {
+                    calculateCoefficientsFromTables();
+                    nc = calculateChi2(1,nx,
+                         countPositive(ii-ni,ii+ni,jj-nj,jj+nj),chi2,se2);
+                }
+                else {
+                    calculateCoefficients(1,nx);
+                    nc = calculateChi2(1,nx,chi2,se2);
+                }
                 if( nc > NP_2D && chi2/(nc-NP_2D) < chi2_max ) {
                     if( se2 < dfsmoo[reg] ) {
                         smoothed[reg] = true; ++ns2d;
@@ -327,6 +439,8 @@ EGS_Smoothing::smooth1(EGS_Distribution2D *the_dose) {
 
     delete [] smoothed;
     delete [] ni_array; delete [] nj_array;
+    if( sat ) { delete [] sat; sat = 0; }
+    if( satc ) { delete [] satc; satc = 0; }
     return result;
 }
 
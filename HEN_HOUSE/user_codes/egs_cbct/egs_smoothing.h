@@ -139,13 +139,29 @@ protected:
 
     double  *cc1, *cc2, *cc3, *cc4, *cc5, *cc6, *ccc;
 
+    /* summed-area tables of f, f*x, f*y, f*x*x, f*y*y and f*x*y
+       (interleaved, x and y relative to the centre of the distribution)
+       and of the number of pixels with a positive error */
+    bool         use_tables;
+    long double  *sat;
+    int          *satc;
+
     void    calculateCoefficients(int Ni, int Nj, bool do_norm = true);
+    void    calculateCoefficientsFromTables();
     void    setCoefficients();
     int     calculateChi2(int,int,double &,double &);
+    int     calculateChi2(int,int,int,double &,double &);
+    void    buildTables(bool moments);
+    int     countPositive(int i1, int i2, int j1, int j2) const {
+        int n1 = nx+1;
+        return satc[(j2+1)*n1+i2+1] - satc[j1*n1+i2+1] -
+               satc[(j2+1)*n1+i1]   + satc[j1*n1+i1];
+    };
 
     bool    smooth1D(int iii, int Nx, int Ni, int &nn, double &se2, double &ww);
     void    setDefaults() {
         nmax = 0; setNmax(3); chi2_max = 1; setDimensions(0,0);
+        use_tables = true; sat = 0; satc = 0;
     };
 
 public:
@@ -163,6 +179,10 @@ public:
     void  setNmax2d(int Nmax) { nmax3d = Nmax; };
     void  setNmax(int Nmax);
     void  setChi2Max(double chi2) { chi2_max = chi2; };
+    /* use summed-area tables for the window sums (default) or
+       the original direct summation. The tables of the moments are only
+       used if long double has more precision than double */
+    void  setUseTables(bool use) { use_tables = use; };
     void  setDmin(double Dmin) { dmin = Dmin; };
     void  setDimensions(int Nx, int Ny) {
         nx = Nx; ny = Ny;;
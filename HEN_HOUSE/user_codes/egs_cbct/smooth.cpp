@@ -39,6 +39,7 @@ using namespace std;
 
 #include "egs_smoothing.h"
 #include "egs_functions.h"
+#include "egs_timer.h"
 
 //const int Nx = 64, Ny = 64;
 
@@ -46,7 +47,7 @@ int main(int argc, char**argv) {
 
     int nmax = 4, nmax2d = 3;
     double chi2max = 1, dmin = 0.02;
-    int Nx = 64, Ny = 64, Nz = 72;
+    int Nx = 64, Ny = 64, Nz = 72, ntiming = 0;
     char *ifile=0, *ofile=0, *bench=0;
     for(int j=1; j<argc-1; j++) {
         string tmp(argv[j]);
@@ -60,12 +61,12 @@ int main(int argc, char**argv) {
         else if( tmp == "-nx" ) Nx = atoi(argv[++j]);
         else if( tmp == "-ny" ) Ny = atoi(argv[++j]);
         else if( tmp == "-nz" ) Nz = atoi(argv[++j]);
-        else if( tmp == "-nz" ) Nz = atoi(argv[++j]);
+        else if( tmp == "-timing" ) ntiming = atoi(argv[++j]);
         else cerr << "Unknown option " << argv[j] << endl;
     }
     if( !ifile ) {
         cerr << "Usage: " << argv[0] << " -i input [-o output] [-nmax n] "
-             << "[-nmax2d n2d] [-chi2max chi2]\n";
+             << "[-nmax2d n2d] [-chi2max chi2] [-timing nrepeat]\n";
         return 1;
     }
 
@@ -107,12 +108,38 @@ int main(int argc, char**argv) {
                  "   parameters is null! Smoothed scan identical\n"
                  "   to original scan!\n");
     }
+    /* with -timing n each projection is smoothed n times using the direct
+       summation and n times using the summed-area tables */
+    EGS_Timer timer; double cpu_direct = 0, cpu_tables = 0;
+    int ndiff = 0; double maxdiff = 0;
     for(int iproj=0; iproj<Nz; iproj++){
 
         EGS_Distribution2D* scan = proj.get_proj(iproj);
         EGS_Distribution2D* b    = 0;
         if( be ) {b = be->get_proj(iproj);}
 
+        if( ntiming > 0 ) {
+            EGS_Distribution2D *res[2];
+            for(int m=0; m<2; m++) {
+                smoo.setUseTables(m == 1);
+                timer.start();
+                for(int k=0; k<ntiming; k++) {
+                    EGS_Distribution2D tmp(*scan);// smooth1 changes its input
+                    res[m] = smoo.smooth1(&tmp);
+                    if( k < ntiming-1 ) delete res[m];
+                }
+                if( m ) cpu_tables += timer.time();
+                else    cpu_direct += timer.time();
+            }
+            for(int j=0; j<Nx*Ny; j++) {
+                double aux = fabs(res[0]->d_array[j] - res[1]->d_array[j]);
+                if( aux > 0 ) ++ndiff;
+                if( res[0]->d_array[j] && aux/fabs(res[0]->d_array[j]) > maxdiff )
+                    maxdiff = aux/fabs(res[0]->d_array[j]);
+            }
+            delete res[0]; delete res[1];
+        }
+
         double sumo = 0, maxdo = 0;
         if( be ) {
            for(int j=0; j<Nx*Ny; j++) {
@@ -144,6 +171,14 @@ int main(int argc, char**argv) {
         out.write((char *) smoothed->d_array,smoothed->nreg*sizeof(float));
     }
     egsInformation(" done !\n");
+    if( ntiming > 0 ) {
+        egsInformation("\nCPU time per projection: direct summation %g s,"
+                       " summed-area tables %g s (speedup %g)\n",
+                       cpu_direct/(Nz*ntiming),cpu_tables/(Nz*ntiming),
+                       cpu_tables > 0 ? cpu_direct/cpu_tables : 0.);
+        egsInformation("Pixels differing: %d out of %d, max. relative"
+                       " difference %g\n",ndiff,Nx*Ny*Nz,maxdiff);
+    }
 
     out.close();
     delete be;
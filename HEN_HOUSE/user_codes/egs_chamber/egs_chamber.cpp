@@ -120,59 +120,51 @@ extern __extc__ struct EGS_ExtraStack F77_OBJ_(extra_stack,EXTRA_STACK);
 static struct EGS_ExtraStack *the_extra_stack =
                  &F77_OBJ_(extra_stack,EXTRA_STACK);
 
-/*! a class for storing the phase-space temporarilly */
+/*! a class for storing the phase-space temporarilly
 
-#define MAXPHSP 100000
+  The particles are stored in fixed size chunks that are allocated as
+  needed and kept until the object is destroyed, so that growing the
+  container never copies particles, there is no upper limit on the number
+  of particles, and clean() at the start of a history frees nothing.
+*/
 class TmpPhsp {
 public:
     // constructor
-    TmpPhsp() : np(0), ntot(4), p(new EGS_Particle[4]), nbr_split(new int[4]) {};
-    ~TmpPhsp() { delete [] p; delete [] nbr_split; };
-    void grow() {
-        int ntot_new = 2*ntot;
-        if( ntot_new > MAXPHSP ) egsFatal("TmpPhsp::grow(): exceeded maximum size %d\n",MAXPHSP);
-        EGS_Particle *pnew = new EGS_Particle [ntot_new];
-        for(int j=0; j<np; j++) pnew[j] = p[j];
-        delete [] p;
-        p = pnew; ntot = ntot_new;
-
-        int *nbr_split_new = new int [ntot_new];
-        for(int j=0; j<np; j++) nbr_split_new[j] = nbr_split[j];
-        delete [] nbr_split;
-        nbr_split = nbr_split_new;
+    TmpPhsp() : nchunk(0), nchunk_max(0), np(0), chunks(0) {};
+    ~TmpPhsp() {
+        for(int j=0; j<nchunk; j++) delete [] chunks[j];
+        if( chunks ) delete [] chunks;
     };
 
-    void set() {
-        if( np > ntot-1 ) grow();
-        int ip = the_stack->np-1;
-        p[np].q     = the_stack->iq[ip];
-        p[np].latch = the_stack->latch[ip];
-        p[np].ir    = the_stack->ir[ip];
-        p[np].E     = the_stack->E[ip];
-        p[np].wt    = the_stack->wt[ip];
-        p[np].x     = EGS_Vector(the_stack->x[ip],the_stack->y[ip],the_stack->z[ip]);
-        p[np].u   = EGS_Vector(the_stack->u[ip],the_stack->v[ip],the_stack->w[ip]);
-
-        nbr_split[np++] = the_extra_stack->nbr_splitting[ip];
+    /*! store the particle on top of the stack */
+    void set() { store(the_stack->np-1,slot()); };
+    /*! store \a n copies of the particle on top of the stack */
+    void set(int n) {
+        if( n < 1 ) return;
+        Entry *e = slot();
+        store(the_stack->np-1,e);
+        for(int j=1; j<n; j++) *slot() = *e;
     };
     void set(const EGS_Particle &particle) {
-        if( np > ntot-1 ) grow();
-        p[np++] = particle;
+        Entry *e = slot();
+        e->p = particle; e->nbr_split = 0;
     };
+    /*! pop the last particle stored to the top of the stack */
     void get(){
         int ip = the_stack->np-1; --np;
-        the_stack->x[ip]  = p[np].x.x;
-        the_stack->y[ip]  = p[np].x.y;
-        the_stack->z[ip]  = p[np].x.z;
-        the_stack->u[ip]  = p[np].u.x;
-        the_stack->v[ip]  = p[np].u.y;
-        the_stack->w[ip]  = p[np].u.z;
-        the_stack->E[ip]  = p[np].E;
-        the_stack->iq[ip] = p[np].q;
-        the_stack->latch[ip] = p[np].latch;
-        the_stack->wt[ip] = p[np].wt;
-
-        the_extra_stack->nbr_splitting[ip] = nbr_split[np];
+        const Entry &e = entry(np);
+        the_stack->x[ip]  = e.p.x.x;
+        the_stack->y[ip]  = e.p.x.y;
+        the_stack->z[ip]  = e.p.x.z;
+        the_stack->u[ip]  = e.p.u.x;
+        the_stack->v[ip]  = e.p.u.y;
+        the_stack->w[ip]  = e.p.u.z;
+        the_stack->E[ip]  = e.p.E;
+        the_stack->iq[ip] = e.p.q;
+        the_stack->latch[ip] = e.p.latch;
+        the_stack->wt[ip] = e.p.wt;
+
+        the_extra_stack->nbr_splitting[ip] = e.nbr_split;
     };
 
     void clean() { np = 0; };
@@ -183,9 +175,46 @@ public:
 
 private:
 
-    int          ntot, np;
-    EGS_Particle *p;
-    int *nbr_split;
+    struct Entry {
+        EGS_Particle p;
+        int          nbr_split;
+    };
+
+    enum { chunk_bits = 10, chunk_size = 1 << chunk_bits };
+
+    Entry &entry(int j) const {
+        return chunks[j >> chunk_bits][j & (chunk_size-1)];
+    };
+
+    /*! a slot for the next particle, allocating a new chunk if needed */
+    Entry *slot() {
+        if( np >= nchunk*chunk_size ) {
+            if( nchunk >= nchunk_max ) {
+                // only the chunk pointers are copied
+                int nchunk_max_new = nchunk_max > 0 ? 2*nchunk_max : 4;
+                Entry **chunks_new = new Entry* [nchunk_max_new];
+                for(int j=0; j<nchunk; j++) chunks_new[j] = chunks[j];
+                if( chunks ) delete [] chunks;
+                chunks = chunks_new; nchunk_max = nchunk_max_new;
+            }
+            chunks[nchunk++] = new Entry [chunk_size];
+        }
+        return &entry(np++);
+    };
+
+    void store(int ip, Entry *e) {
+        e->p.q     = the_stack->iq[ip];
+        e->p.latch = the_stack->latch[ip];
+        e->p.ir    = the_stack->ir[ip];
+        e->p.E     = the_stack->E[ip];
+        e->p.wt    = the_stack->wt[ip];
+        e->p.x     = EGS_Vector(the_stack->x[ip],the_stack->y[ip],the_stack->z[ip]);
+        e->p.u     = EGS_Vector(the_stack->u[ip],the_stack->v[ip],the_stack->w[ip]);
+        e->nbr_split = the_extra_stack->nbr_splitting[ip];
+    };
+
+    int          nchunk, nchunk_max, np;
+    Entry        **chunks;
 };
 
 //*HB_start************************
@@ -963,7 +992,7 @@ int EGS_ChamberApplication::initScoring() {
         //
         if( !vr->getInput("radiative splitting", csplit) && csplit > 1) {
             egsInformation("\n => initScoring: splitting radiative events %d times ...\n", csplit);
-           the_egsvr->nbr_split = csplit;
+           setRadiativeSplitting(csplit);
         }
 
         //
@@ -2332,46 +2361,66 @@ int EGS_ChamberApplication::simulateSingleShower() {
                     save_dose = 0;
                     // get tmpPhsp1 and use as a source
                     while(container->size() > 0){
-                        int tmppc2 = container->size();
+                        // The position, direction and region of the particle in
+                        // this geometry do not depend on the recycling index
+                        // => transform and locate it once and restore the
+                        // result for each recycled copy.
+                        nsmall_step = 0;
+                        the_stack->np = 1;
+                        container->get();
+                        EGS_Vector xt(the_stack->x[0], the_stack->y[0], the_stack->z[0]);
+                        if( transforms[ig] ) {
+                            transforms[ig]->transform(xt);
+                            EGS_Vector ut(the_stack->u[0], the_stack->v[0], the_stack->w[0]);
+                            transforms[ig]->rotate(ut);
+                            the_stack->u[0] = ut.x; the_stack->v[0] = ut.y; the_stack->w[0] = ut.z;
+                            the_stack->x[0] = xt.x; the_stack->y[0] = xt.y; the_stack->z[0] = xt.z;
+                        }
+                        //HB Nov. 2009: Could implement motion of paricle here for positioning uncertainty
+                        //*HB_start************************
+                        //cavity positioning uncertainty (implem here to avoid delay in shift if particle do not reach TmpPhsp)
+                        if(cav_pu_flag) {
+                            if(cav_pu_do_shift) {
+                                pu_distributor[jpu]->setNewShifts(rndm);
+                                cav_pu_do_shift = false;
+                            }
+                            EGS_Vector tmp1 = pu_distributor[jpu]->getRotation();
+                            EGS_RotationMatrix Rtmp = EGS_RotationMatrix(-tmp1.x,-tmp1.y,-tmp1.z);
+                            EGS_Vector ut(the_stack->u[0], the_stack->v[0], the_stack->w[0]);
+                            //EGS_Vector xt(the_stack->x[0], the_stack->y[0], the_stack->z[0]);
+                            xt = Rtmp*xt;
+                            ut = Rtmp*ut;
+                            EGS_Vector tmp2 = pu_distributor[jpu]->getTranslation();
+                            xt.x -= tmp2.x;
+                            xt.y -= tmp2.y;
+                            xt.z -= tmp2.z;
+                            the_stack->u[0] = ut.x; the_stack->v[0] = ut.y; the_stack->w[0] = ut.z;
+                            the_stack->x[0] = xt.x; the_stack->y[0] = xt.y; the_stack->z[0] = xt.z;
+                        }
+                        //*HB_end**************************
+
+                        int ir_t = geometry->isWhere(xt) + 2;
+                        if( ir_t < 2 ) continue;
+                        EGS_Particle pt;
+                        pt.x = xt;
+                        pt.u = EGS_Vector(the_stack->u[0], the_stack->v[0], the_stack->w[0]);
+                        pt.E = the_stack->E[0];
+                        pt.q = the_stack->iq[0];
+                        pt.latch = the_stack->latch[0];
+                        pt.wt = the_stack->wt[0];
+                        int nsplit_t = the_extra_stack->nbr_splitting[0];
                         //recycle particles
                         for( int i=0; i< do_TmpPhsp; i++){
-                            container->setPointer(tmppc2);
                             nsmall_step = 0;
                             the_stack->np = 1;
-                            container->get();
-                            EGS_Vector xt(the_stack->x[0], the_stack->y[0], the_stack->z[0]);
-                            if( transforms[ig] ) {
-                                transforms[ig]->transform(xt);
-                                EGS_Vector ut(the_stack->u[0], the_stack->v[0], the_stack->w[0]);
-                                transforms[ig]->rotate(ut);
-                                the_stack->u[0] = ut.x; the_stack->v[0] = ut.y; the_stack->w[0] = ut.z;
-                                the_stack->x[0] = xt.x; the_stack->y[0] = xt.y; the_stack->z[0] = xt.z;
-                            }
-                            //HB Nov. 2009: Could implement motion of paricle here for positioning uncertainty
-                            //*HB_start************************
-                            //cavity positioning uncertainty (implem here to avoid delay in shift if particle do not reach TmpPhsp)
-                            if(cav_pu_flag) {
-                                if(cav_pu_do_shift) {
-                                    pu_distributor[jpu]->setNewShifts(rndm);
-                                    cav_pu_do_shift = false;
-                                }
-                                EGS_Vector tmp1 = pu_distributor[jpu]->getRotation();
-                                EGS_RotationMatrix Rtmp = EGS_RotationMatrix(-tmp1.x,-tmp1.y,-tmp1.z);
-                                EGS_Vector ut(the_stack->u[0], the_stack->v[0], the_stack->w[0]);
-                                //EGS_Vector xt(the_stack->x[0], the_stack->y[0], the_stack->z[0]);
-                                xt = Rtmp*xt;
-                                ut = Rtmp*ut;
-                                EGS_Vector tmp2 = pu_distributor[jpu]->getTranslation();
-                                xt.x -= tmp2.x;
-                                xt.y -= tmp2.y;
-                                xt.z -= tmp2.z;
-                                the_stack->u[0] = ut.x; the_stack->v[0] = ut.y; the_stack->w[0] = ut.z;
-                                the_stack->x[0] = xt.x; the_stack->y[0] = xt.y; the_stack->z[0] = xt.z;
-                            }
-                            //*HB_end**************************
-
-                            the_stack->ir[0] = geometry->isWhere(xt) + 2;
-                            if( the_stack->ir[0] < 2 ) continue;
+                            the_stack->x[0] = pt.x.x; the_stack->y[0] = pt.x.y; the_stack->z[0] = pt.x.z;
+                            the_stack->u[0] = pt.u.x; the_stack->v[0] = pt.u.y; the_stack->w[0] = pt.u.z;
+                            the_stack->E[0] = pt.E;
+                            the_stack->iq[0] = pt.q;
+                            the_stack->latch[0] = pt.latch;
+                            the_stack->wt[0] = pt.wt;
+                            the_extra_stack->nbr_splitting[0] = nsplit_t;
+                            the_stack->ir[0] = ir_t;
                             the_stack->wt[0] /= (EGS_Float)do_TmpPhsp;// adjust weight due to splitting
                             the_extra_stack->nbr_splitting[0] /= do_TmpPhsp; // nbr_split is only set for fat electrons ph
                             the_stack->dnear[0] = 0;
@@ -2385,9 +2434,7 @@ int EGS_ChamberApplication::simulateSingleShower() {
                                     // split since CSE increased in this reg
                                     int n_esplit = cs_enhance[ig][ir]/cs_enhance[0][basereg];
                                     the_stack->wt[0] = the_stack->wt[0]/(EGS_Float)n_esplit;
-                                    for(int i=0; i<n_esplit; i++){
-                                        container3->set();
-                                    }
+                                    container3->set(n_esplit);
                                     while(container3->size() > 0){
                                         nsmall_step = 0;
                                         the_stack->dnear[0] = 0;
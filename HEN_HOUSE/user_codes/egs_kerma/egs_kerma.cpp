@@ -112,7 +112,8 @@ public:
     EGS_KermaApplication(int argc, char **argv) :
         EGS_AdvancedApplication(argc,argv), ngeom(0),
         kerma(0), kerma_r(0), scg(0), fd_geom(0),
-        ncg(0), flug(0),flugT(0) {
+        ncg(0), flug(0),flugT(0), mi_gmfp(0), mi_cohe(0),
+        muen_E(-1), muen_gle(0), muen_val(0), muen_ig(-1) {
         Eph_ave = 0.0;
         Nph = 0.0;
         Eph_sc  = 0.0;
@@ -122,6 +123,12 @@ public:
 
     /*! Destructor.  */
     ~EGS_KermaApplication() {
+        if (mi_gmfp) {
+            delete mi_gmfp;
+        }
+        if (mi_cohe) {
+            delete mi_cohe;
+        }
         if (ngeom > 0) {
             if (kerma_r) {
                 for (int j=0; j<ngeom; j++) if (kerma_r[j]) {
@@ -202,8 +209,15 @@ public:
             /* Track-Length Kerma scoring (classic) */
             if (is_sensitive[ig][ir]) {
                 if (!fd_geom) {
-                    EGS_Float E = the_stack->E[np], gle = log(E),
-                              emuen   = E_Muen_Rho->interpolateFast(gle)*rho_cv[ig],
+                    EGS_Float E = the_stack->E[np];
+                    if (E != muen_E || ig != muen_ig) {
+                        // A photon takes many steps at the same energy
+                        muen_E   = E;
+                        muen_ig  = ig;
+                        muen_gle = log(E);
+                        muen_val = E_Muen_Rho->interpolateFast(muen_gle)*rho_cv[ig];
+                    }
+                    EGS_Float emuen   = muen_val,
                               wtstep  = the_stack->wt[np]*the_epcont->tvstep;
                     kerma->score(ig,wtstep*emuen);
                     if (kerma_r[ig]) {
@@ -216,10 +230,7 @@ public:
                     // score photon fluence
                     //--------------------------------------------
                     if (flug) {
-                        EGS_Float e = E;
-                        if (flu_s) {
-                            e = log(e);
-                        }
+                        EGS_Float e = flu_s ? muen_gle : E;
                         EGS_Float ae;
                         int je;
                         if (e > flu_xmin && e <= flu_xmax) {
@@ -344,8 +355,11 @@ public:
         int imed = -1;
         EGS_Float gmfp, sigma = 0, cohfac = 1, mu_cv = 0;
         EGS_Float gle = the_epcont->gle, wt_att = 1, Lambda_to_CV = 0;
+        // the energy does not change along the ray => one index for all media
+        int igle = mi_gmfp ? mi_gmfp->getIndexFast(gle) : 0;
         double Lambda = 0, t_sc_tot = 0;
         double t_sc[2*n_scoring_r[ig]];
+        EGS_Float exp_sc[2*n_scoring_r[ig]];
         int   ir_sc[2*n_scoring_r[ig]];
         int n_ir_sc = 0;
         bool inside_cv  = false, re_enters_cv = false, navigating = true;
@@ -360,10 +374,19 @@ public:
                 if (imed != newmed) {
                     imed = newmed;
                     if (imed >= 0) {
-                        gmfp = i_gmfp[imed].interpolateFast(gle);
-                        if (the_xoptions->iraylr) {
-                            cohfac = i_cohe[imed].interpolateFast(gle);
-                            gmfp *= cohfac;
+                        if (mi_gmfp) {
+                            gmfp = mi_gmfp->interpolateFast(igle,imed,gle);
+                            if (the_xoptions->iraylr) {
+                                cohfac = mi_cohe->interpolateFast(igle,imed,gle);
+                                gmfp *= cohfac;
+                            }
+                        }
+                        else {
+                            gmfp = i_gmfp[imed].interpolateFast(gle);
+                            if (the_xoptions->iraylr) {
+                                cohfac = i_cohe[imed].interpolateFast(gle);
+                                gmfp *= cohfac;
+                            }
                         }
                         sigma = 1/gmfp;
                     }
@@ -415,11 +438,27 @@ public:
                           exp_Lambda = exp_Lambda_to_CV,
                           exp_CV     = 1.0,
                           exp_Att, edepCV;
+                EGS_Float edep_cv = emuen_rho*rho_cv[ig];// Data base contains E_muen/rho values
+                // Attenuation through each scoring region crossed, all at once
+                for (int i = 0; i < n_ir_sc; i++) {
+                    exp_sc[i] = exp(-mu_cv*t_sc[i]);
+                }
+                // The fluence energy bin is the same for all scoring regions
+                int je = -1;
+                if (flug) {
+                    EGS_Float e = the_stack->E[np];
+                    if (flu_s) {
+                        e = log(e);
+                    }
+                    if (e > flu_xmin && e <= flu_xmax) {
+                        EGS_Float ae = flu_a*e + flu_b;
+                        je = min((int)ae,flu_nbin-1);
+                    }
+                }
                 for (int i = 0; i < n_ir_sc; i++) {
-                    edepCV     = emuen_rho*rho_cv[ig];// Data base contains E_muen/rho values
-                    exp_CV     = exp(-mu_cv*t_sc[i]);
+                    exp_CV     = exp_sc[i];
                     exp_Att    = sigma ? exp_Lambda*(1-exp_CV)/mu_cv : 1.0 ;//Attenuation in scoring region
-                    edepCV    *= exp_Att;
+                    edepCV     = edep_cv*exp_Att;
                     //--------------------------------------------
                     // score kerma in scoring region
                     //--------------------------------------------
@@ -431,17 +470,8 @@ public:
                     //--------------------------------------------
                     if (flug) {
                         flugT[ig]->score(ir_sc[i],wt*exp_Att);
-                        EGS_Float e = the_stack->E[np];
-                        if (flu_s) {
-                            e = log(e);
-                        }
-                        EGS_Float ae;
-                        int je;
-                        if (e > flu_xmin && e <= flu_xmax) {
-                            ae = flu_a*e + flu_b;
-                            je = min((int)ae,flu_nbin-1);
-                            EGS_ScoringArray *aux = flug[ig];
-                            aux->score(je,wt*exp_Att);
+                        if (je >= 0) {
+                            flug[ig]->score(je,wt*exp_Att);
                         }
                     }
                     else {
@@ -457,10 +487,9 @@ public:
                 //--------------------------------------------
                 // score total kerma and fluence in CV
                 //--------------------------------------------
-                edepCV     = emuen_rho*rho_cv[ig];// Data base contains E_muen/rho values
                 exp_CV     = exp(-mu_cv*t_sc_tot);
                 exp_Att    = sigma ? exp_Lambda_to_CV*(1-exp_CV)/mu_cv : 1.0;
-                edepCV    *= exp_Att;
+                edepCV     = edep_cv*exp_Att;
                 kerma->score(ig,wt*edepCV);
                 // Ray-tracing continues
                 if (re_enters_cv) {
@@ -1058,6 +1087,18 @@ private:
 
     EGS_Interpolator *E_Muen_Rho;
 
+    /* Photon mean free path and Rayleigh interpolators with the
+       coefficients of all media for a bin stored contiguously, used for
+       the ray-tracing in scoreInCV(). Null if the media do not share
+       the same interpolation grid. */
+    EGS_MultiInterpolator *mi_gmfp, *mi_cohe;
+
+    /* E*muen/rho*rho_cv for the last photon energy and geometry scored in
+       ausgab(), so that the interpolation is done once per photon and
+       not once per step. */
+    EGS_Float muen_E, muen_gle, muen_val;
+    int       muen_ig;
+
     /****************************************************************/
 
     EGS_ScoringArray **flug;    // Differential fluence in ALL scoring regions
@@ -1726,6 +1767,20 @@ int EGS_KermaApplication::initScoring() {
         return 2;
     }
 
+    // Ray-tracing interpolators. The mean free path and Rayleigh data of
+    // a medium share the same energy grid, so this only fails if the
+    // grids differ between media.
+    if (nmed > 0) {
+        mi_gmfp = new EGS_MultiInterpolator(nmed,i_gmfp);
+        mi_cohe = new EGS_MultiInterpolator(nmed,i_cohe);
+        if (!mi_gmfp->isValid() || !mi_cohe->isValid()) {
+            delete mi_gmfp;
+            delete mi_cohe;
+            mi_gmfp = 0;
+            mi_cohe = 0;
+        }
+    }
+
     return 0;
 }
 